@@ -1,4 +1,6 @@
+#include <boost/asio/signal_set.hpp>
 #include <csignal>
+#include <cstdlib>
 #include <thread>
 
 #include "db/db.hpp"
@@ -6,25 +8,24 @@
 #include "server/server.hpp"
 #include "sync/sync.hpp"
 
-void signalExit(int) {
-  exit(0);
-}
-
 int main() {
-  signal(SIGINT, signalExit);
-  signal(SIGTERM, signalExit);
-
   bcx::config.load();
   bcx::db::load();
   bcx::Server server;
   auto &io = server.io();
+  boost::asio::signal_set signals{io, SIGINT, SIGTERM};
+  signals.async_wait([&](auto &&...) { io.stop(); });
   std::thread sync;
   if (!bcx::config.disable_sync()) {
-    sync = std::thread{[&]() { bcx::runSync(server.io()); }};
+    sync = std::thread{[&]() { bcx::runSync(); }};
   }
   server.run();
+  bcx::db::close();
   if (sync.joinable()) {
-    sync.join();
+    // sync may wait for new blocks forever, and its threads still use db, config and logger,
+    // so exit without running static destructors
+    bcx::logger::default_logger()->flush();
+    std::_Exit(0);
   }
   return 0;
 }
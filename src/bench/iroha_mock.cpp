@@ -0,0 +1,195 @@
+#include <boost/filesystem.hpp>
+#include <random>
+#include <thread>
+
+#include "bench/iroha_mock.hpp"
+#include "cache/cache.hpp"
+#include "format/format.hpp"
+
+namespace bcx::bench {
+  IrohaMock::IrohaMock(std::vector<iroha::protocol::Block> chain, size_t committed, const Faults &faults)
+      : chain_{std::move(chain)}, faults_{faults}, committed_{std::min(committed, chain_.size())} {
+    grpc::ServerBuilder builder;
+    int port = 0;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(this);
+    server_ = builder.BuildAndStart();
+    if (!server_ || port == 0) {
+      fatal("Can't start iroha mock");
+    }
+    address_ = "127.0.0.1:" + std::to_string(port);
+  }
+
+  IrohaMock::~IrohaMock() {
+    finish();
+    server_->Shutdown();
+  }
+
+  const std::string &IrohaMock::address() const {
+    return address_;
+  }
+
+  size_t IrohaMock::size() const {
+    return chain_.size();
+  }
+
+  void IrohaMock::commit(size_t height) {
+    {
+      std::lock_guard lock{mutex_};
+      committed_ = std::max(committed_, std::min(height, chain_.size()));
+    }
+    committed_cv_.notify_all();
+  }
+
+  void IrohaMock::finish() {
+    {
+      std::lock_guard lock{mutex_};
+      finished_ = true;
+    }
+    committed_cv_.notify_all();
+  }
+
+  size_t IrohaMock::calls() const {
+    return calls_;
+  }
+
+  size_t IrohaMock::errors() const {
+    return errors_;
+  }
+
+  size_t IrohaMock::maxConcurrent() const {
+    return max_concurrent_;
+  }
+
+  grpc::Status IrohaMock::Find(grpc::ServerContext *context,
+                               const iroha::protocol::Query *query,
+                               iroha::protocol::QueryResponse *response) {
+    auto call = ++calls_;
+    auto concurrent = ++concurrent_;
+    for (auto max = max_concurrent_.load(); concurrent > max && !max_concurrent_.compare_exchange_weak(max, concurrent);) {
+    }
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    if (faults_.latency.count() != 0) {
+      std::this_thread::sleep_for(faults_.latency / 2 + std::chrono::microseconds(rng() % faults_.latency.count()));
+    }
+    --concurrent_;
+    if (!query->payload().has_get_block()) {
+      return grpc::Status{grpc::StatusCode::UNIMPLEMENTED, "only GetBlock is served"};
+    }
+    if (call > faults_.clean_calls && rng() % 100 < faults_.error_percent) {
+      ++errors_;
+      return grpc::Status{grpc::StatusCode::UNAVAILABLE, "injected error"};
+    }
+    auto height = query->payload().get_block().height();
+    size_t committed;
+    {
+      std::lock_guard lock{mutex_};
+      committed = committed_;
+    }
+    if (height == 0 || height > committed) {
+      auto error = response->mutable_error_response();
+      error->set_reason(iroha::protocol::ErrorResponse::STATEFUL_INVALID);
+      error->set_error_code(3);
+      error->set_message("invalid height");
+      return grpc::Status::OK;
+    }
+    *response->mutable_block_response()->mutable_block() = chain_[height - 1];
+    return grpc::Status::OK;
+  }
+
+  grpc::Status IrohaMock::FetchCommits(grpc::ServerContext *context,
+                                       const iroha::protocol::BlocksQuery *query,
+                                       grpc::ServerWriter<iroha::protocol::BlockQueryResponse> *writer) {
+    std::unique_lock lock{mutex_};
+    auto height = committed_;
+    while (true) {
+      committed_cv_.wait(lock, [&]() { return finished_ || committed_ > height; });
+      if (committed_ == height) {
+        return grpc::Status::OK;
+      }
+      auto end = committed_;
+      lock.unlock();
+      for (; height < end; ++height) {
+        iroha::protocol::BlockQueryResponse response;
+        *response.mutable_block_response()->mutable_block() = chain_[height];
+        if (!writer->Write(response)) {
+          return grpc::Status::CANCELLED;
+        }
+      }
+      lock.lock();
+    }
+  }
+
+  std::vector<iroha::protocol::Block> syntheticChain(size_t blocks, size_t txs) {
+    constexpr uint64_t kStartTime = 1600000000000;
+    constexpr uint64_t kBlockTime = 5000;
+    auto key = [](size_t i) {
+      EDKey key{};
+      std::copy_n(reinterpret_cast<const Byte *>(&i), sizeof(i), key.begin());
+      return format::hex(key);
+    };
+    std::vector<iroha::protocol::Block> chain(blocks);
+    for (size_t height = 1; height <= blocks; ++height) {
+      auto payload = chain[height - 1].mutable_block_v1()->mutable_payload();
+      payload->set_height(height);
+      payload->set_created_time(kStartTime + height * kBlockTime);
+      payload->set_prev_block_hash(height == 1 ? format::hex(Sha256{}) : format::hex(format::blockHash(chain[height - 2])));
+      auto addTx = [&](const std::string &creator, size_t i) {
+        auto tx = payload->add_transactions();
+        auto reduced = tx->mutable_payload()->mutable_reduced_payload();
+        reduced->set_creator_account_id(creator);
+        reduced->set_created_time(payload->created_time() - i);
+        reduced->set_quorum(1);
+        auto signature = tx->add_signatures();
+        signature->set_public_key(key(0));
+        signature->set_signature(std::string(128, '0'));
+        return reduced;
+      };
+      if (height == 1) {
+        auto reduced = addTx("", 0);
+        auto role = reduced->add_commands()->mutable_create_role();
+        role->set_role_name("user");
+        role->add_permissions(iroha::protocol::can_get_blocks);
+        auto domain = reduced->add_commands()->mutable_create_domain();
+        domain->set_domain_id("bench");
+        domain->set_default_role("user");
+        auto account = reduced->add_commands()->mutable_create_account();
+        account->set_account_name("admin");
+        account->set_domain_id("bench");
+        account->set_public_key(key(0));
+        auto peer = reduced->add_commands()->mutable_add_peer()->mutable_peer();
+        peer->set_address("127.0.0.1:10001");
+        peer->set_peer_key(key(1));
+        continue;
+      }
+      for (size_t i = 0; i < txs; ++i) {
+        auto reduced = addTx("admin@bench", i);
+        auto account = reduced->add_commands()->mutable_create_account();
+        account->set_account_name("u" + std::to_string(height) + "_" + std::to_string(i));
+        account->set_domain_id("bench");
+        account->set_public_key(key(height * txs + i));
+        if (i == 0 && height % 10 == 0) {
+          auto quorum = reduced->add_commands()->mutable_set_account_quorum();
+          quorum->set_account_id("admin@bench");
+          quorum->set_quorum(1 + height / 10 % 2);
+        }
+      }
+    }
+    return chain;
+  }
+
+  std::vector<iroha::protocol::Block> recordedChain(const std::string &data_dir) {
+    auto path = boost::filesystem::path{data_dir};
+    cache::Blocks blocks;
+    blocks.open((path / "blocks").string(), (path / "block.cache").string(), 0, {1, {}});
+    std::vector<iroha::protocol::Block> chain(blocks.size());
+    for (size_t i = 0; i < chain.size(); ++i) {
+      auto bytes = blocks[i];
+      if (!chain[i].ParseFromArray(bytes.data(), bytes.size())) {
+        fatal("Recorded block {} corrupted", i + 1);
+      }
+    }
+    blocks.close();
+    return chain;
+  }
+}  // namespace bcx::bench
@@ -0,0 +1,66 @@
+#ifndef BCX_BENCH_IROHA_MOCK_HPP
+#define BCX_BENCH_IROHA_MOCK_HPP
+
+#include <grpcpp/grpcpp.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gen/pb/endpoint.grpc.pb.h"
+
+namespace bcx::bench {
+  // injected into GetBlock calls, latency is uniform in [latency / 2, latency * 3 / 2) so completions reorder
+  struct Faults {
+    std::chrono::microseconds latency{0};
+    size_t error_percent = 0;
+    // first calls get no errors, sync starts with synchronous checkAccount and same(last height) that don't retry
+    size_t clean_calls = 2;
+  };
+
+  // in-process iroha on random local port.
+  // GetBlock serves committed blocks, FetchCommits streams blocks committed after subscription.
+  class IrohaMock : public iroha::protocol::QueryService_v1::Service {
+   public:
+    IrohaMock(std::vector<iroha::protocol::Block> chain, size_t committed, const Faults &faults);
+    ~IrohaMock() override;
+
+    const std::string &address() const;
+    size_t size() const;
+    void commit(size_t height);
+    // FetchCommits streams end after writing committed blocks
+    void finish();
+
+    size_t calls() const;
+    size_t errors() const;
+    size_t maxConcurrent() const;
+
+    grpc::Status Find(grpc::ServerContext *context,
+                      const iroha::protocol::Query *query,
+                      iroha::protocol::QueryResponse *response) override;
+    grpc::Status FetchCommits(grpc::ServerContext *context,
+                              const iroha::protocol::BlocksQuery *query,
+                              grpc::ServerWriter<iroha::protocol::BlockQueryResponse> *writer) override;
+
+   private:
+    std::vector<iroha::protocol::Block> chain_;
+    Faults faults_;
+    std::mutex mutex_;
+    std::condition_variable committed_cv_;
+    size_t committed_;
+    bool finished_{false};
+    std::atomic_size_t calls_{0}, errors_{0}, concurrent_{0}, max_concurrent_{0};
+    std::string address_;
+    std::unique_ptr<grpc::Server> server_;
+  };
+
+  // genesis creates role, domain, admin account and peer, other blocks have `txs` transactions of admin
+  std::vector<iroha::protocol::Block> syntheticChain(size_t blocks, size_t txs);
+  // blocks from block cache of explorer data directory
+  std::vector<iroha::protocol::Block> recordedChain(const std::string &data_dir);
+}  // namespace bcx::bench
+
+#endif  // BCX_BENCH_IROHA_MOCK_HPP
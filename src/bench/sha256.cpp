@@ -0,0 +1,63 @@
+#include <chrono>
+#include <random>
+
+#include "format/format.hpp"
+
+using namespace bcx;
+
+constexpr size_t kBatch = 128;
+constexpr size_t kRounds = 200;
+
+// transaction payloads are typically a few hundred bytes
+auto makeInputs() {
+  std::mt19937 rng{0};
+  std::vector<std::string> inputs(kBatch);
+  for (auto &input : inputs) {
+    input.resize(100 + rng() % 400);
+    for (auto &c : input) {
+      c = static_cast<char>(rng());
+    }
+  }
+  return inputs;
+}
+
+template <typename F>
+void bench(const std::string &name, size_t bytes, const F &f) {
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for (auto i = 0u; i < kRounds; ++i) {
+    f();
+  }
+  std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+  logger::info("{:>16}: {:8.0f} hashes/s {:8.1f} MB/s",
+               name,
+               kRounds * kBatch / time.count(),
+               kRounds * bytes / time.count() / 1e6);
+}
+
+int main() {
+  auto inputs = makeInputs();
+  std::vector<std::string_view> views{inputs.begin(), inputs.end()};
+  size_t bytes = 0;
+  for (auto &input : inputs) {
+    bytes += input.size();
+  }
+  std::vector<Sha256> out(kBatch);
+  auto &scalar = format::sha256Engines().back();
+
+  logger::info("batch of {} buffers, {} bytes", kBatch, bytes);
+  bench("per-call", bytes, [&]() {
+    for (auto i = 0u; i < kBatch; ++i) {
+      scalar.hash(&out[i], &views[i], 1);
+    }
+  });
+  for (auto &engine : format::sha256Engines()) {
+    if (!engine.supported()) {
+      logger::info("{:>16}: not supported", engine.name);
+      continue;
+    }
+    bench(engine.name, bytes, [&]() { engine.hash(out.data(), views.data(), kBatch); });
+  }
+  bench("dispatch", bytes, [&]() { format::sha256(out.data(), views.data(), kBatch); });
+  return 0;
+}
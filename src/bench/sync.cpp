@@ -0,0 +1,110 @@
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <thread>
+
+#include "bench/iroha_mock.hpp"
+#include "db/db.hpp"
+#include "format/format.hpp"
+#include "sync/sync.hpp"
+
+using namespace bcx;
+
+size_t getenvSize(const char *name, size_t fallback) {
+  auto value = std::getenv(name);
+  return value == nullptr ? fallback : std::stoull(value);
+}
+
+using Clock = std::chrono::steady_clock;
+
+void waitBlocks(size_t n) {
+  while (db::blockCount() < n) {
+    std::this_thread::sleep_for(std::chrono::microseconds{200});
+  }
+}
+
+void report(const std::string &name, size_t blocks, size_t txs, std::chrono::duration<double> time) {
+  logger::info("{:>10}: {:7} blocks {:8} tx in {:6.2f} s, {:8.0f} blocks/s {:9.0f} tx/s",
+               name,
+               blocks,
+               txs,
+               time.count(),
+               blocks / time.count(),
+               txs / time.count());
+}
+
+// catch-up fetches BENCH_BLOCKS blocks with GetBlock, following streams next BENCH_FOLLOW_BLOCKS.
+// blocks are synthetic with BENCH_TXS transactions, or recorded from BENCH_CHAIN_DIR data directory.
+// MOCK_LATENCY_US and MOCK_ERROR_PERCENT are injected into GetBlock calls, except startup ones.
+// following commits one block per BENCH_COMMIT_MS, or all at once if 0.
+int main() {
+  auto follow = getenvSize("BENCH_FOLLOW_BLOCKS", 1000);
+  auto commit_interval = std::chrono::milliseconds{getenvSize("BENCH_COMMIT_MS", 0)};
+  std::vector<iroha::protocol::Block> chain;
+  if (auto dir = std::getenv("BENCH_CHAIN_DIR")) {
+    chain = bench::recordedChain(dir);
+  } else {
+    chain = bench::syntheticChain(getenvSize("BENCH_BLOCKS", 10000) + follow, getenvSize("BENCH_TXS", 10));
+  }
+  if (chain.size() <= follow) {
+    fatal("Chain of {} blocks is too short to follow {}", chain.size(), follow);
+  }
+  auto blocks = chain.size() - follow;
+  bench::Faults faults{std::chrono::microseconds{getenvSize("MOCK_LATENCY_US", 0)}, getenvSize("MOCK_ERROR_PERCENT", 0)};
+  bench::IrohaMock iroha{std::move(chain), blocks, faults};
+
+  auto data_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("bcx-bench-%%%%-%%%%");
+  boost::filesystem::create_directories(data_dir);
+  setenv("DATA_DIR", data_dir.c_str(), 1);
+  setenv("IROHA_HOST", iroha.address().c_str(), 1);
+  setenv("IROHA_ACCOUNT", "admin@bench", 1);
+  setenv("IROHA_ACCOUNT_KEY", format::hex(EDKey{}).c_str(), 1);
+  setenv("DISABLE_SYNC", "0", 1);
+  // sync logs every block
+  setenv("LOG_LEVEL", "warn", 0);
+  config.load();
+  db::load();
+
+  auto start = Clock::now();
+  std::thread sync{[]() { runSync(); }};
+  waitBlocks(blocks);
+  auto catch_up_txs = db::txCount();
+  std::chrono::duration<double> catch_up_time = Clock::now() - start;
+  auto catch_up_calls = iroha.calls();
+
+  start = Clock::now();
+  Clock::duration lag{};
+  if (commit_interval.count() == 0) {
+    iroha.commit(blocks + follow);
+  } else {
+    for (auto height = blocks + 1; height <= blocks + follow; ++height) {
+      auto commit_time = Clock::now();
+      iroha.commit(height);
+      waitBlocks(height);
+      lag += Clock::now() - commit_time;
+      std::this_thread::sleep_until(commit_time + commit_interval);
+    }
+  }
+  waitBlocks(blocks + follow);
+  std::chrono::duration<double> follow_time = Clock::now() - start;
+  auto follow_txs = db::txCount() - catch_up_txs;
+  iroha.finish();
+  sync.join();
+  db::close();
+  boost::filesystem::remove_all(data_dir);
+
+  setLogLevel("info");
+  logger::info("GetBlock latency {} us, {}% errors, {} calls, {} errors, {} max concurrent",
+               faults.latency.count(),
+               faults.error_percent,
+               catch_up_calls,
+               iroha.errors(),
+               iroha.maxConcurrent());
+  report("catch-up", blocks, catch_up_txs, catch_up_time);
+  report("following", follow, follow_txs, follow_time);
+  if (commit_interval.count() != 0) {
+    logger::info("commit every {} ms, {:.2f} ms mean lag until applied",
+                 commit_interval.count(),
+                 std::chrono::duration<double, std::milli>(lag).count() / follow);
+  }
+  return 0;
+}
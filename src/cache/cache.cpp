@@ -0,0 +1,409 @@
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include "cache/cache.hpp"
+#include "ds/ds.hpp"
+#include "format/format.hpp"
+#include "gen/pb/block.pb.h"
+
+namespace bcx::cache {
+  constexpr uint64_t kSegmentMagic = 0x67657365786362;
+  constexpr uint32_t kVersion = 1;
+  constexpr size_t kSegmentSize = size_t{256} << 20;
+  constexpr size_t kMaxSegmentSize = std::numeric_limits<uint32_t>::max();
+  constexpr size_t kMaxPendingBytes = size_t{256} << 20;
+
+  struct SegmentHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t segment;
+    uint64_t first_block;
+  };
+
+  namespace {
+    void writeAll(int fd, const void *data, size_t size, size_t offset) {
+      auto ptr = static_cast<const char *>(data);
+      while (size != 0) {
+        auto n = ::pwrite(fd, ptr, size, offset);
+        if (n == -1 && errno == EINTR) {
+          continue;
+        }
+        if (n <= 0) {
+          fatal("Block cache write failed: {}", std::strerror(errno));
+        }
+        ptr += n;
+        size -= n;
+        offset += n;
+      }
+    }
+
+    bool readAll(int fd, void *data, size_t size, size_t offset) {
+      auto ptr = static_cast<char *>(data);
+      while (size != 0) {
+        auto n = ::pread(fd, ptr, size, offset);
+        if (n == -1 && errno == EINTR) {
+          continue;
+        }
+        if (n <= 0) {
+          return false;
+        }
+        ptr += n;
+        size -= n;
+        offset += n;
+      }
+      return true;
+    }
+
+    void resize(int fd, size_t size) {
+      if (::ftruncate(fd, size) != 0) {
+        fatal("Block cache truncate failed: {}", std::strerror(errno));
+      }
+    }
+  }  // namespace
+
+  Blocks::~Blocks() {
+    close();
+  }
+
+  void Blocks::open(const std::string &dir,
+                    const std::string &legacy_path,
+                    size_t verify_threads,
+                    const Durability &durability) {
+    dir_ = dir;
+    durability_ = durability;
+    if (!boost::filesystem::exists(dir_) && boost::filesystem::exists(legacy_path)) {
+      migrate(legacy_path);
+    }
+    boost::filesystem::create_directories(dir_);
+    load(verify_threads);
+  }
+
+  size_t Blocks::size() const {
+    return index_.size();
+  }
+
+  size_t Blocks::durable() const {
+    return durable_;
+  }
+
+  std::string_view Blocks::operator[](size_t i) const {
+    if (i >= durable_) {
+      return *pending_[i - pending_first_].bytes;
+    }
+    return mapped(i);
+  }
+
+  Bytes Blocks::get(size_t i) const {
+    if (i < durable_) {
+      return {mapped(i), nullptr};
+    }
+    std::lock_guard lock{mutex_};
+    if (i < durable_) {
+      return {mapped(i), nullptr};
+    }
+    auto &bytes = pending_[i - pending_first_].bytes;
+    return {*bytes, bytes};
+  }
+
+  std::string_view Blocks::mapped(size_t i) const {
+    auto &entry = index_[i];
+    return {segments_[entry.segment].data + entry.offset, entry.size};
+  }
+
+  void Blocks::push_back(std::string_view bytes) {
+    if (sizeof(SegmentHeader) + bytes.size() > kMaxSegmentSize) {
+      fatal("Block {} is too big to cache", size() + 1);
+    }
+    if (segments_.empty() || segments_.back().size + bytes.size() > segments_.back().capacity) {
+      addSegment(sizeof(SegmentHeader) + bytes.size());
+    }
+    auto &segment = segments_.back();
+    Entry entry{static_cast<uint32_t>(segments_.size() - 1),
+                static_cast<uint32_t>(segment.size),
+                static_cast<uint32_t>(bytes.size()),
+                format::crc32c(bytes)};
+    segment.size += bytes.size();
+    std::unique_lock lock{mutex_};
+    if (pending_bytes_ > kMaxPendingBytes) {
+      flush_ = true;
+      pending_cv_.notify_one();
+      durable_cv_.wait(lock, [&] { return pending_bytes_ <= kMaxPendingBytes; });
+    }
+    while (pending_first_ < durable_) {
+      pending_.pop_front();
+      ++pending_first_;
+    }
+    // first pending block starts time window, writer waits for its deadline
+    auto first = pending_first_ + pending_.size() == durable_;
+    if (first) {
+      pending_time_ = std::chrono::steady_clock::now();
+    }
+    pending_.push_back({entry, segment.fd, std::make_shared<const std::string>(bytes)});
+    index_.push_back(entry);
+    pending_bytes_ += bytes.size();
+    if (first || pending_first_ + pending_.size() - durable_ >= durability_.blocks) {
+      pending_cv_.notify_one();
+    }
+  }
+
+  void Blocks::truncate(size_t n) {
+    if (n > size()) {
+      fatal("Blocks::truncate invalid argument");
+    }
+    sync();
+    pending_.clear();
+    pending_first_ = n;
+    durable_ = n;
+    index_.resize(n);
+    resize(index_fd_, n * sizeof(Entry));
+    auto keep = index_.empty() ? 0 : index_.back().segment + 1;
+    while (segments_.size() > keep) {
+      closeSegment(true);
+    }
+    if (!segments_.empty()) {
+      auto &segment = segments_.back();
+      segment.size = index_.back().offset + index_.back().size;
+      resize(segment.fd, segment.size);
+    }
+  }
+
+  // waits until all appended blocks are durable
+  void Blocks::sync() {
+    std::unique_lock lock{mutex_};
+    if (durable_ == size()) {
+      return;
+    }
+    flush_ = true;
+    pending_cv_.notify_one();
+    durable_cv_.wait(lock, [&] { return durable_ == size(); });
+  }
+
+  void Blocks::load(size_t verify_threads) {
+    index_fd_ = ::open((dir_ + "/index").c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (index_fd_ == -1 || ::fstat(index_fd_, &st) != 0) {
+      fatal("Can't open block cache index in {}", dir_);
+    }
+    std::vector<Entry> index(st.st_size / sizeof(Entry));
+    if (!readAll(index_fd_, index.data(), index.size() * sizeof(Entry), 0)) {
+      fatal("Can't read block cache index in {}", dir_);
+    }
+    for (auto &entry : index) {
+      index_.push_back(entry);
+    }
+    pending_first_ = durable_ = size();
+    for (auto i = 0u; openSegment(i); ++i) {
+    }
+    auto n = valid();
+    if (verify_threads != 0) {
+      n = verified(n, verify_threads);
+    }
+    if (n != size()) {
+      logger::warn("Block cache corrupted, truncating {} blocks", size() - n);
+    }
+    truncate(n);
+    stop_ = false;
+    writer_ = std::thread{[this] { write(); }};
+  }
+
+  // group commit loop, batch is written and synced while new blocks keep pending in memory
+  void Blocks::write() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      pending_cv_.wait(lock, [&] { return stop_ || durable_ != size(); });
+      if (durable_ == size()) {
+        return;
+      }
+      pending_cv_.wait_until(lock, pending_time_ + durability_.time, [&] {
+        return stop_ || flush_ || size() - durable_ >= durability_.blocks;
+      });
+      auto begin = durable_.load(), end = size();
+      std::vector<const Pending *> batch;
+      for (auto i = begin; i < end; ++i) {
+        batch.push_back(&pending_[i - pending_first_]);
+      }
+      lock.unlock();
+
+      std::vector<Entry> entries;
+      std::vector<int> fds;
+      size_t bytes = 0;
+      for (auto pending : batch) {
+        writeAll(pending->fd, pending->bytes->data(), pending->bytes->size(), pending->entry.offset);
+        entries.push_back(pending->entry);
+        if (fds.empty() || fds.back() != pending->fd) {
+          fds.push_back(pending->fd);
+        }
+        bytes += pending->bytes->size();
+      }
+      writeAll(index_fd_, entries.data(), entries.size() * sizeof(Entry), begin * sizeof(Entry));
+      for (auto fd : fds) {
+        ::fdatasync(fd);
+      }
+      ::fdatasync(index_fd_);
+
+      lock.lock();
+      durable_ = end;
+      pending_bytes_ -= bytes;
+      pending_time_ = std::chrono::steady_clock::now();
+      if (durable_ == size()) {
+        flush_ = false;
+      }
+      durable_cv_.notify_all();
+    }
+  }
+
+  void Blocks::close() {
+    if (writer_.joinable()) {
+      {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+      }
+      pending_cv_.notify_one();
+      writer_.join();
+    }
+    while (!segments_.empty()) {
+      closeSegment(false);
+    }
+    if (index_fd_ != -1) {
+      ::close(index_fd_);
+      index_fd_ = -1;
+    }
+    index_.resize(0);
+    pending_.clear();
+    pending_first_ = 0;
+    durable_ = 0;
+  }
+
+  // converts single file block cache, which needed full scan to split blocks
+  void Blocks::migrate(const std::string &legacy_path) {
+    auto legacy = format::mapBytes(legacy_path);
+    ds::Len len;
+    format::splitPb(len, legacy.bytes, iroha::protocol::Block::kBlockV1FieldNumber);
+    if (len.size_bytes() != legacy.bytes.size()) {
+      fatal("Block cache {} corrupted after block {} at byte {}, remove it to fetch blocks again",
+            legacy_path,
+            len.size(),
+            len.size_bytes());
+    }
+    logger::info("Migrating {} blocks from {} to {}", len.size(), legacy_path, dir_);
+    auto dir = dir_;
+    dir_ += ".tmp";
+    boost::filesystem::remove_all(dir_);
+    boost::filesystem::create_directories(dir_);
+    load(0);
+    for (auto i = 0u; i < len.size(); ++i) {
+      push_back(legacy.bytes.substr(len.offset(i), len.size(i)));
+    }
+    sync();
+    close();
+    boost::filesystem::rename(dir_, dir);
+    dir_ = dir;
+    boost::filesystem::remove(legacy_path);
+  }
+
+  bool Blocks::openSegment(size_t i) {
+    auto path = segmentPath(i);
+    auto fd = ::open(path.c_str(), O_RDWR);
+    if (fd == -1) {
+      return false;
+    }
+    SegmentHeader header{};
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !readAll(fd, &header, sizeof(header), 0) || header.magic != kSegmentMagic
+        || header.version != kVersion || header.segment != i) {
+      logger::warn("Block cache segment {} invalid", path);
+      ::close(fd);
+      return false;
+    }
+    mapSegment(fd, st.st_size, std::max<size_t>(kSegmentSize, st.st_size), header.first_block);
+    return true;
+  }
+
+  void Blocks::addSegment(size_t min_capacity) {
+    auto i = segments_.size();
+    auto path = segmentPath(i);
+    auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+      fatal("Can't create block cache segment {}", path);
+    }
+    SegmentHeader header{kSegmentMagic, kVersion, static_cast<uint32_t>(i), size()};
+    writeAll(fd, &header, sizeof(header), 0);
+    mapSegment(fd, sizeof(header), std::max(kSegmentSize, min_capacity), header.first_block);
+  }
+
+  // maps whole capacity, appended bytes become visible through the mapping
+  void Blocks::mapSegment(int fd, size_t size, size_t capacity, size_t first_block) {
+    auto ptr = ::mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      fatal("Can't map block cache segment: {}", std::strerror(errno));
+    }
+    segments_.push_back({fd, size, capacity, first_block, static_cast<const char *>(ptr)});
+  }
+
+  void Blocks::closeSegment(bool remove) {
+    auto &segment = segments_.back();
+    ::munmap(const_cast<char *>(segment.data), segment.capacity);
+    ::close(segment.fd);
+    if (remove) {
+      boost::filesystem::remove(segmentPath(segments_.size() - 1));
+    }
+    segments_.resize(segments_.size() - 1);
+  }
+
+  std::string Blocks::segmentPath(size_t i) const {
+    return fmt::format("{}/{:08}.seg", dir_, i);
+  }
+
+  // length of index prefix pointing to consecutive records inside segments
+  size_t Blocks::valid() const {
+    size_t segment = 0, end = sizeof(SegmentHeader);
+    for (auto i = 0u; i < index_.size(); ++i) {
+      auto &entry = index_[i];
+      if (entry.segment == segment + 1) {
+        segment = entry.segment;
+        end = sizeof(SegmentHeader);
+      }
+      if (entry.segment != segment || segment >= segments_.size() || entry.offset != end
+          || end + entry.size > segments_[segment].size
+          || (end == sizeof(SegmentHeader) && segments_[segment].first_block != i)) {
+        return i;
+      }
+      end += entry.size;
+    }
+    return index_.size();
+  }
+
+  // length of index prefix with matching checksums, checked in parallel
+  size_t Blocks::verified(size_t n, size_t threads) const {
+    std::atomic_size_t bad{n};
+    std::vector<std::thread> workers;
+    auto chunk = (n + threads - 1) / threads;
+    for (auto t = 0u; t < threads; ++t) {
+      workers.emplace_back([&, begin = t * chunk]() {
+        auto end = std::min(n, begin + chunk);
+        for (auto i = begin; i < end && i < bad; ++i) {
+          if (format::crc32c((*this)[i]) != index_[i].crc) {
+            auto current = bad.load();
+            while (i < current && !bad.compare_exchange_weak(current, i)) {
+            }
+            break;
+          }
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    if (bad != n) {
+      logger::warn("Cached block {} checksum mismatch", bad + 1);
+    }
+    return bad;
+  }
+}  // namespace bcx::cache
@@ -0,0 +1,106 @@
+#ifndef BCX_CACHE_CACHE_HPP
+#define BCX_CACHE_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ds/ds.hpp"
+#include "types.hpp"
+
+namespace bcx::cache {
+  // block location, `segment` file at `offset`, and crc32c of its bytes
+  struct Entry {
+    uint32_t segment;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t crc;
+  };
+
+  // group commit window, appended blocks become durable together after `blocks` appends or `time` since first of them
+  struct Durability {
+    size_t blocks;
+    std::chrono::milliseconds time;
+  };
+
+  // block bytes, `owner` keeps not yet durable block alive
+  struct Bytes {
+    std::string_view view;
+    std::shared_ptr<const std::string> owner;
+  };
+
+  // append-only block storage, fixed-size memory-mapped segment files and offset index.
+  // appended blocks are served from memory until background writer makes them durable.
+  // operator[] is for appending thread, concurrent readers use `get`.
+  class Blocks {
+   public:
+    Blocks() = default;
+    Blocks(const Blocks &) = delete;
+    ~Blocks();
+
+    void open(const std::string &dir,
+              const std::string &legacy_path,
+              size_t verify_threads,
+              const Durability &durability);
+    size_t size() const;
+    size_t durable() const;
+    std::string_view operator[](size_t i) const;
+    Bytes get(size_t i) const;
+    void push_back(std::string_view bytes);
+    void truncate(size_t n);
+    void sync();
+    void close();
+
+   private:
+    struct Segment {
+      int fd;
+      size_t size;
+      size_t capacity;
+      size_t first_block;
+      const char *data;
+    };
+
+    struct Pending {
+      Entry entry;
+      int fd;
+      std::shared_ptr<const std::string> bytes;
+    };
+
+    void load(size_t verify_threads);
+    void write();
+    std::string_view mapped(size_t i) const;
+    void migrate(const std::string &legacy_path);
+    bool openSegment(size_t i);
+    void addSegment(size_t min_capacity);
+    void mapSegment(int fd, size_t size, size_t capacity, size_t first_block);
+    void closeSegment(bool remove);
+    std::string segmentPath(size_t i) const;
+    size_t valid() const;
+    size_t verified(size_t n, size_t threads) const;
+
+    std::string dir_;
+    int index_fd_{-1};
+    ds::Chunked<Entry> index_;
+    ds::Chunked<Segment> segments_;
+
+    Durability durability_{1, {}};
+    std::thread writer_;
+    mutable std::mutex mutex_;
+    std::condition_variable pending_cv_, durable_cv_;
+    std::deque<Pending> pending_;
+    size_t pending_first_{0};
+    size_t pending_bytes_{0};
+    std::chrono::steady_clock::time_point pending_time_;
+    std::atomic_size_t durable_{0};
+    bool flush_{false};
+    bool stop_{false};
+  };
+}  // namespace bcx::cache
+
+#endif  // BCX_CACHE_CACHE_HPP
@@ -1,4 +1,11 @@
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <shared_mutex>
+#include <thread>
 
 #include "db/db.hpp"
 #include "format/format.hpp"
@@ -12,7 +19,10 @@ namespace bcx::db {
   static_assert(iroha::protocol::Transaction_Payload::kReducedPayloadFieldNumber == 1);
   static_assert(iroha::protocol::Transaction_Payload_ReducedPayload::kCommandsFieldNumber == 1);
 
-  constexpr auto kBlockCache = "block.cache";
+  constexpr uint64_t kSnapshotMagic = 0x706e736e78636221;
+  constexpr uint32_t kSnapshotVersion = 6;
+  constexpr size_t kSnapshotMinBlocks = 1000;
+  constexpr size_t kLoadWindowPerThread = 64;
 
   DEFINE_STATIC(block_bytes);
   static size_t block_count;
@@ -30,6 +40,11 @@ namespace bcx::db {
   DEFINE_STATIC(account_quorum);
   DEFINE_STATIC(account_roles);
   DEFINE_STATIC(account_grant);
+  DEFINE_STATIC(account_grant_mutex);
+  DEFINE_STATIC(account_txs);
+  DEFINE_STATIC(account_txs_mutex);
+  DEFINE_STATIC(account_id_ngrams);
+  DEFINE_STATIC(account_id_ngrams_mutex);
   static size_t peer_count;
   DEFINE_STATIC(peer_address);
   DEFINE_STATIC(peer_pub);
@@ -41,7 +56,55 @@ namespace bcx::db {
   DEFINE_STATIC(domain_role);
   DEFINE_STATIC(domain_tx_count);
   DEFINE_STATIC(all_pub);
-  static std::ofstream appender;
+  // transaction which first used key, keys are numbered in order of first use
+  static ds::Chunked<Id> all_pub_tx;
+  DEFINE_STATIC(block_rollup);
+  DEFINE_STATIC(tx_rollup);
+  DEFINE_STATIC(command_rollup);
+  DEFINE_STATIC(rollback_mutex);
+  static std::atomic_size_t rollbacks;
+  // values replaced by quorum and grant updates, popped when rollback undoes them
+  static ds::Chunked<size_t> quorum_undo;
+  static ds::Chunked<unsigned long long> grant_undo;
+  // snapshot of empty db, resets data before rebuilding it
+  static std::string empty_state;
+  static std::atomic_size_t hash_verify_sample;
+  static std::mutex writer_mutex;
+  static bool closed;
+
+  // seqlock, counts are published by writer after each block
+  namespace published {
+    static std::atomic_size_t seq, block, tx, account, peer, role, domain;
+
+    void store() {
+      auto s = seq.load(std::memory_order_relaxed);
+      seq.store(s + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      block.store(block_count, std::memory_order_relaxed);
+      tx.store(tx_count, std::memory_order_relaxed);
+      account.store(account_count, std::memory_order_relaxed);
+      peer.store(peer_count, std::memory_order_relaxed);
+      role.store(role_count, std::memory_order_relaxed);
+      domain.store(domain_count, std::memory_order_relaxed);
+      seq.store(s + 2, std::memory_order_release);
+    }
+
+    Counts load() {
+      while (true) {
+        auto s = seq.load(std::memory_order_acquire);
+        Counts counts{block.load(std::memory_order_relaxed),
+                      tx.load(std::memory_order_relaxed),
+                      account.load(std::memory_order_relaxed),
+                      peer.load(std::memory_order_relaxed),
+                      role.load(std::memory_order_relaxed),
+                      domain.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s % 2 == 0 && seq.load(std::memory_order_relaxed) == s) {
+          return counts;
+        }
+      }
+    }
+  }  // namespace published
 
   namespace genesis {
     constexpr size_t domain = 0;
@@ -57,7 +120,7 @@ namespace bcx::db {
             ++role_count;
             role_name.push_back(name);
             role_perms.push_back({});
-            constexpr size_t role = 0;
+            constexpr Id role = 0;
 
             ++domain_count;
             domain_id.push_back(name);
@@ -75,51 +138,340 @@ namespace bcx::db {
     }
   }  // namespace genesis
 
-  void flush() {
-    appender.flush();
+  void reset();
+
+  namespace snapshot {
+    struct Header {
+      uint64_t magic;
+      uint32_t version;
+      uint64_t height;
+      Sha256 hash;
+    };
+
+    struct GrantRow {
+      size_t by, to;
+      unsigned long long perms;
+    };
+
+    // block count of snapshot file
+    static size_t height = 0;
+
+    template <typename Io>
+    void io(Io &io) {
+      io(block_count)(block_hash)(block_time)(block_tx_count);
+      io(tx_count)(tx_hash)(tx_time)(tx_creator)(tx_pubs)(tx_cmds);
+      io(account_count)(account_id)(account_quorum)(account_roles);
+      io(peer_count)(peer_address)(peer_pub);
+      io(role_count)(role_name)(role_perms);
+      io(domain_count)(domain_id)(domain_role)(domain_tx_count);
+      io(all_pub)(all_pub_tx);
+      io(quorum_undo)(grant_undo);
+      io(block_rollup)(tx_rollup)(command_rollup);
+      std::vector<GrantRow> grants;
+      if constexpr (!Io::kRead) {
+        for (auto &x : account_grant) {
+          grants.push_back({x.left, x.right, x.info.to_ullong()});
+        }
+      }
+      io(grants);
+      if constexpr (Io::kRead) {
+        account_grant.clear();
+        for (auto &grant : grants) {
+          account_grant.insert({ds::toId(grant.by), ds::toId(grant.to), GrantPerms{grant.perms}});
+        }
+      }
+    }
+
+    void save() {
+      if (block_count == 0 || block_count != block_bytes.size()) {
+        return;
+      }
+      // snapshot is ignored on load if it is ahead of block cache
+      block_bytes.sync();
+      auto tmp_path = config.snapshot_path + ".tmp";
+      {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        ds::Writer io{file};
+        Header header{kSnapshotMagic, kSnapshotVersion, block_count, block_hash.back()};
+        io(header);
+        snapshot::io(io);
+        io(header.magic);
+        if (!file.good()) {
+          logger::warn("Can't write snapshot {}", tmp_path);
+          return;
+        }
+      }
+      boost::filesystem::rename(tmp_path, config.snapshot_path);
+      height = block_count;
+      logger::info("Saved snapshot of {} blocks", block_count);
+    }
+
+    // saves if at least `blocks` were added since snapshot, 0 never saves
+    void saveAfter(size_t blocks) {
+      if (blocks != 0 && block_count >= height + blocks) {
+        save();
+      }
+    }
+
+    size_t load() {
+      std::ifstream file(config.snapshot_path, std::ios::binary | std::ios::ate);
+      if (!file.good()) {
+        return 0;
+      }
+      ds::Reader io{file, static_cast<size_t>(file.tellg())};
+      file.seekg(0, std::ios::beg);
+      Header header;
+      io(header);
+      if (!io.ok || header.magic != kSnapshotMagic || header.version != kSnapshotVersion) {
+        logger::warn("Snapshot format unknown, ignoring");
+        return 0;
+      }
+      if (header.height == 0 || header.height > block_bytes.size()) {
+        logger::warn("Snapshot is ahead of block cache, ignoring");
+        return 0;
+      }
+      format::BlockSpans spans;
+      if (!format::blockSpans(spans, block_bytes[header.height - 1]) || format::sha256(spans.payload) != header.hash) {
+        logger::warn("Snapshot differs from block cache, ignoring");
+        return 0;
+      }
+      snapshot::io(io);
+      uint64_t magic = 0;
+      io(magic);
+      if (!io.ok || magic != kSnapshotMagic || block_count != header.height) {
+        boost::filesystem::remove(config.snapshot_path);
+        logger::warn("Snapshot corrupted, removed {}", config.snapshot_path);
+        reset();
+        return 0;
+      }
+      height = header.height;
+      return header.height;
+    }
+  }  // namespace snapshot
+
+  void indexTxCreators(size_t begin) {
+    std::unique_lock lock{account_txs_mutex};
+    account_txs.resize(account_count);
+    for (auto i = begin; i < tx_count; ++i) {
+      account_txs[tx_creator[i]].push_back(i);
+    }
+  }
+
+  void indexAccountIds(size_t begin) {
+    std::unique_lock lock{account_id_ngrams_mutex};
+    for (auto i = begin; i < account_count; ++i) {
+      account_id_ngrams.add(i, account_id[i]);
+    }
   }
 
   void truncate(size_t n) {
     block_bytes.truncate(n);
-    std::ofstream(config.block_cache_path, std::ios::binary | std::ios::trunc)
-        .write(b2c(block_bytes.bytes.data()), block_bytes.bytes.size());
   }
 
-  void load() {
-    auto load_start_time = std::chrono::system_clock::now();
+  void reset() {
+    std::istringstream stream{empty_state};
+    ds::Reader io{stream, empty_state.size()};
+    snapshot::io(io);
+    {
+      std::unique_lock lock{account_txs_mutex};
+      account_txs.clear();
+    }
+    std::unique_lock lock{account_id_ngrams_mutex};
+    account_id_ngrams = {};
+  }
 
-    block_bytes.bytes = format::readBytes(config.block_cache_path);
-    format::splitPb(block_bytes.len, bv2sv(block_bytes.bytes), iroha::protocol::Block::kBlockV1);
-    auto extra = block_bytes.bytes.size() - block_bytes.size_bytes();
-    if (extra) {
-      logger::warn("Block cache corrupted, truncating {} bytes", extra);
-      truncate(block_bytes.size());
+  // compares span hashes with re-serialized ones on sampled blocks
+  void verifyHashes(Digest &digest, const iroha::protocol::Block &block) {
+    auto mismatch = false;
+    auto verify = [&](Sha256 &hash, const Sha256 &expected) {
+      mismatch |= hash != expected;
+      hash = expected;
+    };
+    verify(digest.hash, format::blockHash(block));
+    auto tx_hash = digest.tx_hash.begin();
+    for (auto &tx_wrap : block.block_v1().payload().transactions()) {
+      verify(*tx_hash++, format::sha256(tx_wrap.payload().reduced_payload().SerializeAsString()));
     }
-    iroha::protocol::Block block;
-    for (auto i = 0u; i < block_bytes.size(); ++i) {
-      auto block_span = block_bytes[i];
-      if (!block.ParseFromArray(block_span.data(), block_span.size())) {
+    if (mismatch && hash_verify_sample.exchange(1) != 1) {
+      logger::warn("Block {} hashes differ from re-serialized, verifying every block", format::blockHeight(block));
+    }
+  }
+
+  // false if bytes don't have expected layout
+  bool digest(Digest &digest, const iroha::protocol::Block &block, std::string_view bytes) {
+    thread_local format::BlockSpans spans;
+    if (!format::blockSpans(spans, bytes) || spans.txs.size() != static_cast<size_t>(block.block_v1().payload().transactions_size())) {
+      return false;
+    }
+    thread_local std::vector<std::string_view> payloads;
+    payloads.clear();
+    digest.tx_cmds.clear();
+    for (auto &tx : spans.txs) {
+      payloads.push_back(tx.reduced_payload);
+      digest.tx_cmds.push_back({ds::toId(tx.commands.data() - bytes.data()), ds::toId(tx.commands.size())});
+    }
+    payloads.push_back(spans.payload);
+    digest.tx_hash.resize(payloads.size());
+    format::sha256(digest.tx_hash.data(), payloads.data(), payloads.size());
+    digest.hash = digest.tx_hash.back();
+    digest.tx_hash.pop_back();
+    digest.pubs.clear();
+    for (auto &tx_wrap : block.block_v1().payload().transactions()) {
+      for (auto &sig : tx_wrap.signatures()) {
+        digest.pubs.push_back(*format::unhex<EDKey>(sig.public_key()));
+      }
+    }
+    auto sample = hash_verify_sample.load();
+    if (sample != 0 && format::blockHeight(block) % sample == 0) {
+      verifyHashes(digest, block);
+    }
+    return true;
+  }
+
+  bool decode(Prepared &decoded, std::string_view bytes) {
+    if (!decoded.block.ParseFromArray(bytes.data(), bytes.size())) {
+      return false;
+    }
+    decoded.digest.bytes.clear();
+    return digest(decoded.digest, decoded.block, bytes);
+  }
+
+  void apply(const iroha::protocol::Block &block, const Digest &digest);
+
+  // decodes cached blocks on `threads` workers, applies them in height order
+  void loadParallel(size_t begin, size_t threads) {
+    auto end = block_bytes.size();
+    auto window = threads * kLoadWindowPerThread;
+    std::vector<Prepared> ring(window);
+    std::vector<bool> ring_ok(window);
+    std::vector<size_t> ring_height(window, 0);
+    std::mutex mutex;
+    std::condition_variable decoded_cv, applied_cv;
+    auto next = begin, applied = begin;
+    auto stop = false;
+    std::vector<std::thread> workers;
+    for (auto t = 0u; t < threads; ++t) {
+      workers.emplace_back([&]() {
+        while (true) {
+          size_t i;
+          {
+            std::unique_lock lock{mutex};
+            applied_cv.wait(lock, [&]() { return stop || next >= end || next < applied + window; });
+            if (stop || next >= end) {
+              return;
+            }
+            i = next++;
+          }
+          auto ok = decode(ring[i % window], block_bytes[i]);
+          {
+            std::lock_guard lock{mutex};
+            ring_ok[i % window] = ok;
+            ring_height[i % window] = i + 1;
+          }
+          decoded_cv.notify_all();
+        }
+      });
+    }
+    for (auto i = begin; i < end; ++i) {
+      bool ok;
+      {
+        std::unique_lock lock{mutex};
+        decoded_cv.wait(lock, [&]() { return ring_height[i % window] == i + 1; });
+        ok = ring_ok[i % window];
+      }
+      if (!ok) {
+        {
+          std::lock_guard lock{mutex};
+          stop = true;
+        }
+        applied_cv.notify_all();
+        for (auto &worker : workers) {
+          worker.join();
+        }
         logger::warn("Cached block {} corrupted, truncating {} blocks",
                      i + 1,
                      block_bytes.size() - i);
         truncate(i);
-        break;
+        return;
+      }
+      apply(ring[i % window].block, ring[i % window].digest);
+      {
+        std::lock_guard lock{mutex};
+        applied = i + 1;
       }
-      addBlock(block);
+      applied_cv.notify_all();
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  // memory of columns holding ids, and what they would take with 64-bit ids
+  void reportIdColumns() {
+    size_t bytes = 0, wide = 0;
+    auto column = [&](size_t n, size_t size, size_t wide_size) {
+      bytes += n * size;
+      wide += n * wide_size;
+    };
+    column(tx_creator.size(), sizeof(Id), sizeof(size_t));
+    column(tx_pubs.size_values() + txCount(), sizeof(Id), sizeof(size_t));
+    column(tx_cmds.size(), sizeof(std::pair<Id, Id>), sizeof(std::pair<size_t, size_t>));
+    column(account_roles.heads.size(), sizeof(Id), sizeof(size_t));
+    column(account_roles.linked.nodes.size(), sizeof(std::pair<Id, Id>), sizeof(std::pair<size_t, size_t>));
+    column(domain_role.size(), sizeof(Id), sizeof(size_t));
+    column(all_pub_tx.size(), sizeof(Id), sizeof(size_t));
+    for (auto capacity : {tx_hash.capacity(), account_id.capacity(), peer_pub.capacity(), role_name.capacity(), domain_id.capacity(), all_pub.capacity()}) {
+      column(capacity, sizeof(Id), sizeof(size_t));
     }
-    appender.open(config.block_cache_path, std::ios::binary | std::ios::app);
-    atexit(flush);
+    constexpr auto kMiB = double(1 << 20);
+    logger::info("Id columns use {:.1f} MiB, {:.1f} MiB saved by 32-bit ids", bytes / kMiB, (wide - bytes) / kMiB);
+  }
+
+  // from snapshot if it matches block cache, then remaining cached blocks
+  size_t restore() {
+    auto snapshot_height = snapshot::load();
+    indexTxCreators(0);
+    indexAccountIds(0);
+    loadParallel(snapshot_height, config.load_threads);
+    return snapshot_height;
+  }
+
+  void load() {
+    auto load_start_time = std::chrono::system_clock::now();
+
+    hash_verify_sample = config.hash_verify_sample;
+
+    block_bytes.open(config.blocks_path,
+                     config.block_cache_path,
+                     config.verify_block_cache ? config.load_threads : 0,
+                     {config.durable_blocks, std::chrono::milliseconds{config.durable_ms}});
+    std::ostringstream stream;
+    ds::Writer io{stream};
+    snapshot::io(io);
+    empty_state = stream.str();
+
+    auto snapshot_height = restore();
+    snapshot::saveAfter(kSnapshotMinBlocks);
 
     auto load_duration = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now() - load_start_time);
-    logger::info("Loaded {} blocks with {} transactions in {} sec",
+    published::store();
+    reportIdColumns();
+    logger::info("Loaded {} blocks ({} from snapshot) with {} transactions in {} sec using {} threads",
                  blockCount(),
+                 snapshot_height,
                  txCount(),
-                 load_duration.count());
+                 load_duration.count(),
+                 config.load_threads);
   }
 
-  void drop() {
-    truncate(0);
+  void close() {
+    std::lock_guard lock{writer_mutex};
+    closed = true;
+    block_bytes.sync();
+    snapshot::saveAfter(kSnapshotMinBlocks);
+    logger::info("Closed with {} durable blocks", block_bytes.durable());
+    block_bytes.close();
   }
 
   auto txCreator(const iroha::protocol::Transaction_Payload_ReducedPayload &payload) {
@@ -132,35 +484,44 @@ namespace bcx::db {
     return creator.empty() ? genesis::domain : *domain_id.find(format::domainOf(creator));
   }
 
-  void addBlock(const iroha::protocol::Block &block) {
+  void apply(const iroha::protocol::Block &block, const Digest &digest) {
     auto height = format::blockHeight(block);
     if (height != block_count + 1) {
       fatal("Expected block {} got {}", block_count + 1, height);
     }
     if (height > block_bytes.size()) {
-      auto bytes = block.SerializeAsString();
-      block_bytes.push_back(bytes);
-      appender.write(bytes.data(), bytes.size());
+      block_bytes.push_back(digest.bytes);
     }
+    auto first_tx = tx_count;
+    auto first_account = account_count;
     genesis::check(block);
-    auto block_i = block_count++;
+    block_count++;
     auto &block_payload = block.block_v1().payload();
-    block_hash.push_back(format::blockHash(block));
+    block_hash.push_back(digest.hash);
     block_time.push_back(block_payload.created_time());
+    block_rollup.add(block_payload.created_time(), 1);
     block_tx_count.push_back(block_payload.transactions_size());
-    format::getTxCmd(tx_cmds, block_bytes[block_i]);
+    for (auto &cmd : digest.tx_cmds) {
+      tx_cmds.push_back(cmd);
+    }
+    auto pub = digest.pubs.begin();
+    auto tx_hash_it = digest.tx_hash.begin();
     for (auto &tx_wrap : block_payload.transactions()) {
       auto tx_i = tx_count++;
       auto &tx_payload = tx_wrap.payload().reduced_payload();
-      tx_hash.push_back(format::sha256(tx_payload.SerializeAsString()));
+      tx_hash.push_back(*tx_hash_it++);
       tx_time.push_back(tx_payload.created_time());
-      for (auto &sig : tx_wrap.signatures()) {
-        auto pub = *format::unhex<EDKey>(sig.public_key());
-        auto pub_i = all_pub.find(pub);
+      auto rollup_time = std::min(tx_payload.created_time(), block_payload.created_time());
+      tx_rollup.add(rollup_time, 1);
+      command_rollup.add(rollup_time, tx_payload.commands_size());
+      for (auto i = 0; i < tx_wrap.signatures_size(); ++i) {
+        auto pub_i = all_pub.find(*pub);
         if (!pub_i) {
           pub_i = all_pub.size();
-          all_pub.push_back(pub);
+          all_pub.push_back(*pub);
+          all_pub_tx.push_back(ds::toId(tx_i));
         }
+        ++pub;
         tx_pubs.add(tx_i, *pub_i);
       }
       for (auto &cmd : tx_payload.commands()) {
@@ -182,14 +543,18 @@ namespace bcx::db {
           }
           case Command::kSetAccountQuorum: {
             auto &set = cmd.set_account_quorum();
-            account_quorum[*account_id.find(set.account_id())] = set.quorum();
+            auto account = *account_id.find(set.account_id());
+            quorum_undo.push_back(account_quorum[account]);
+            account_quorum.store(account, set.quorum());
             break;
           }
           case Command::kGrantPermission: {
             auto &grant = cmd.grant_permission();
-            auto to = *account_id.find(grant.account_id());
-            auto by = txCreator(tx_payload);
+            auto to = ds::toId(*account_id.find(grant.account_id()));
+            auto by = ds::toId(txCreator(tx_payload));
+            std::unique_lock lock{account_grant_mutex};
             auto p = account_grant.find(GrantBimap::key_type{by, to});
+            grant_undo.push_back(p == account_grant.end() ? 0 : p->info.to_ullong());
             if (p == account_grant.end()) {
               p = account_grant.insert({by, to}).first;
             }
@@ -227,31 +592,200 @@ namespace bcx::db {
         }
       }
       tx_creator.push_back(txCreator(tx_payload));
-      ++domain_tx_count[txCreatorDomain(tx_payload)];
+      auto domain = txCreatorDomain(tx_payload);
+      domain_tx_count.store(domain, domain_tx_count[domain] + 1);
     }
+    indexTxCreators(first_tx);
+    indexAccountIds(first_account);
+    published::store();
+  }
+
+  // undoes block applied last
+  void revert(const iroha::protocol::Block &block) {
+    auto &block_payload = block.block_v1().payload();
+    block_rollup.remove(block_payload.created_time(), 1);
+    auto &txs = block_payload.transactions();
+    for (auto tx_wrap = txs.rbegin(); tx_wrap != txs.rend(); ++tx_wrap) {
+      --tx_count;
+      auto &tx_payload = tx_wrap->payload().reduced_payload();
+      auto domain = txCreatorDomain(tx_payload);
+      domain_tx_count.store(domain, domain_tx_count[domain] - 1);
+      auto rollup_time = std::min(tx_payload.created_time(), block_payload.created_time());
+      tx_rollup.remove(rollup_time, 1);
+      command_rollup.remove(rollup_time, tx_payload.commands_size());
+      auto &cmds = tx_payload.commands();
+      for (auto cmd = cmds.rbegin(); cmd != cmds.rend(); ++cmd) {
+        using iroha::protocol::Command;
+        switch (cmd->command_case()) {
+          case Command::kCreateAccount: {
+            account_roles.pop(--account_count);
+            break;
+          }
+          case Command::kAppendRole: {
+            account_roles.pop(*account_id.find(cmd->append_role().account_id()));
+            break;
+          }
+          case Command::kSetAccountQuorum: {
+            account_quorum.store(*account_id.find(cmd->set_account_quorum().account_id()), quorum_undo.back());
+            quorum_undo.truncate(quorum_undo.size() - 1);
+            break;
+          }
+          case Command::kGrantPermission: {
+            auto to = ds::toId(*account_id.find(cmd->grant_permission().account_id()));
+            auto by = ds::toId(txCreator(tx_payload));
+            std::unique_lock lock{account_grant_mutex};
+            auto p = account_grant.find(GrantBimap::key_type{by, to});
+            if (grant_undo.back() == 0) {
+              account_grant.erase(p);
+            } else {
+              p->info = GrantPerms{grant_undo.back()};
+            }
+            grant_undo.truncate(grant_undo.size() - 1);
+            break;
+          }
+          case Command::kAddPeer: {
+            --peer_count;
+            break;
+          }
+          case Command::kCreateRole: {
+            --role_count;
+            break;
+          }
+          case Command::kCreateDomain: {
+            --domain_count;
+            break;
+          }
+          default:
+            break;
+        }
+      }
+    }
+    --block_count;
+  }
+
+  // reverts blocks above height, then cuts columns to remaining counts.
+  // false if removed block can't be parsed, and data is partly reverted.
+  bool undo(size_t height) {
+    iroha::protocol::Block block;
+    while (block_count > height) {
+      auto bytes = block_bytes[block_count - 1];
+      if (!block.ParseFromArray(bytes.data(), bytes.size())) {
+        logger::warn("Cached block {} corrupted, rebuilding data from cached blocks", block_count);
+        return false;
+      }
+      revert(block);
+    }
+    {
+      std::unique_lock lock{account_txs_mutex};
+      for (auto i = tx_creator.size(); i > tx_count; --i) {
+        auto &txs = account_txs[tx_creator[i - 1]];
+        txs.truncate(txs.size() - 1);
+      }
+      account_txs.resize(account_count);
+    }
+    {
+      std::unique_lock lock{account_id_ngrams_mutex};
+      for (auto i = account_id.size(); i > account_count; --i) {
+        account_id_ngrams.remove(i - 1, account_id[i - 1]);
+      }
+    }
+    block_hash.truncate(block_count);
+    block_time.truncate(block_count);
+    block_tx_count.truncate(block_count);
+    tx_hash.truncate(tx_count);
+    tx_time.truncate(tx_count);
+    tx_creator.truncate(tx_count);
+    tx_pubs.truncate(tx_count);
+    tx_cmds.truncate(tx_count);
+    auto pubs = std::lower_bound(all_pub_tx.begin(), all_pub_tx.end(), tx_count) - all_pub_tx.begin();
+    all_pub.truncate(pubs);
+    all_pub_tx.truncate(pubs);
+    account_id.truncate(account_count);
+    account_quorum.truncate(account_count);
+    account_roles.heads.truncate(account_count);
+    peer_address.truncate(peer_count);
+    peer_pub.truncate(peer_count);
+    role_name.truncate(role_count);
+    role_perms.truncate(role_count);
+    domain_id.truncate(domain_count);
+    domain_role.truncate(domain_count);
+    domain_tx_count.truncate(domain_count);
+    return true;
+  }
+
+  void rollback(size_t height) {
+    std::lock_guard lock{writer_mutex};
+    if (closed || height >= block_count) {
+      return;
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    std::unique_lock readers_lock{rollback_mutex};
+    auto removed = block_count - height;
+    // genesis stubs aren't reverted, empty db is reset instead
+    auto undone = height != 0 && undo(height);
+    truncate(height);
+    snapshot::height = std::min(snapshot::height, block_count);
+    if (!undone) {
+      reset();
+      restore();
+    }
+    ++rollbacks;
+    published::store();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+    logger::info("Rolled back {} blocks to {} in {} ms", removed, block_count, duration.count());
+  }
+
+  size_t rollbackCount() {
+    return rollbacks;
+  }
+
+  void prepare(Prepared &prepared) {
+    prepared.digest.bytes = prepared.block.SerializeAsString();
+    if (!digest(prepared.digest, prepared.block, prepared.digest.bytes)) {
+      fatal("Block {} layout unexpected", format::blockHeight(prepared.block));
+    }
+  }
+
+  void addBlocks(const std::vector<Prepared> &blocks) {
+    std::lock_guard lock{writer_mutex};
+    if (closed) {
+      return;
+    }
+    for (auto &prepared : blocks) {
+      apply(prepared.block, prepared.digest);
+    }
+    snapshot::saveAfter(config.snapshot_blocks);
+  }
+
+  Counts counts() {
+    return published::load();
   }
 
   size_t blockCount() {
-    return block_count;
+    return published::block.load(std::memory_order_relaxed);
+  }
+
+  size_t durableBlockCount() {
+    return block_bytes.durable();
   }
 
   size_t txCount() {
-    return tx_count;
+    return published::tx.load(std::memory_order_relaxed);
   }
 
   size_t accountCount() {
-    return account_count;
+    return published::account.load(std::memory_order_relaxed);
   }
 
   size_t peerCount() {
-    return peer_count;
+    return published::peer.load(std::memory_order_relaxed);
   }
 
   size_t roleCount() {
-    return role_count;
+    return published::role.load(std::memory_order_relaxed);
   }
 
   size_t domainCount() {
-    return domain_count;
+    return published::domain.load(std::memory_order_relaxed);
   }
 }  // namespace bcx::db
@@ -4,39 +4,86 @@
 #include <boost/bimap.hpp>
 #include <boost/bimap/multiset_of.hpp>
 #include <boost/range/iterator_range_core.hpp>
+#include <shared_mutex>
 
+#include "cache/cache.hpp"
 #include "ds/ds.hpp"
+#include "gen/pb/block.pb.h"
 
 namespace bcx::db {
-  using GrantBimap = boost::bimap<boost::bimaps::multiset_of<size_t>, boost::bimaps::multiset_of<size_t>, boost::bimaps::with_info<GrantPerms>>;
+  using GrantBimap = boost::bimap<boost::bimaps::multiset_of<Id>, boost::bimaps::multiset_of<Id>, boost::bimaps::with_info<GrantPerms>>;
 
-  extern ds::Strings block_bytes;
-  extern std::vector<Sha256> block_hash;
-  extern std::vector<uint64_t> block_time;
+  // single writer appends blocks, readers use data below published counts without locks.
+  // in-place updated columns are read with `load`, account_grant, account_txs and account_id_ngrams with shared lock.
+  // readers hold shared rollback_mutex, rollback changes data in place under unique lock.
+  extern std::shared_mutex rollback_mutex;
+  extern cache::Blocks block_bytes;
+  extern ds::Chunked<Sha256> block_hash;
+  extern ds::Chunked<uint64_t> block_time;
   extern ds::Len block_tx_count;
-  extern ds::Indirect<false, std::vector<Sha256>>::Hashed tx_hash;
-  extern std::vector<uint64_t> tx_time;
-  extern std::vector<size_t> tx_creator;
-  extern ds::Linked<size_t>::Vector tx_pubs;
-  extern std::vector<std::pair<size_t, size_t>> tx_cmds;
-  extern ds::Indirect<true, ds::Strings>::Hashed account_id;
-  extern std::vector<size_t> account_quorum;
-  extern ds::Linked<size_t>::Vector account_roles;
+  extern ds::Hashed<ds::Chunked<Sha256>> tx_hash;
+  extern ds::Chunked<uint64_t> tx_time;
+  extern ds::Chunked<Id> tx_creator;
+  extern ds::Csr<Id> tx_pubs;
+  // offset in block and size
+  extern ds::Chunked<std::pair<Id, Id>> tx_cmds;
+  extern ds::Hashed<ds::Strings> account_id;
+  extern ds::Chunked<size_t> account_quorum;
+  extern ds::Linked<Id>::Vector account_roles;
   extern GrantBimap account_grant;
+  extern std::shared_mutex account_grant_mutex;
+  // transactions created by account, derived from tx_creator and not saved in snapshot
+  extern std::vector<ds::Postings> account_txs;
+  extern std::shared_mutex account_txs_mutex;
+  // substrings of account_id, derived and not saved in snapshot
+  extern ds::Ngrams account_id_ngrams;
+  extern std::shared_mutex account_id_ngrams_mutex;
   extern ds::Strings peer_address;
-  extern ds::Indirect<false, std::vector<EDKey>>::Hashed peer_pub;
-  extern ds::Indirect<true, ds::Strings>::Hashed role_name;
-  extern std::vector<RolePerms> role_perms;
-  extern ds::Indirect<true, ds::Strings>::Hashed domain_id;
-  extern std::vector<size_t> domain_role;
-  extern std::vector<size_t> domain_tx_count;
-  extern ds::Indirect<false, std::vector<EDKey>>::Hashed all_pub;
+  extern ds::Hashed<ds::Chunked<EDKey>> peer_pub;
+  extern ds::Hashed<ds::Strings> role_name;
+  extern ds::Chunked<RolePerms> role_perms;
+  extern ds::Hashed<ds::Strings> domain_id;
+  extern ds::Chunked<Id> domain_role;
+  extern ds::Chunked<size_t> domain_tx_count;
+  extern ds::Hashed<ds::Chunked<EDKey>> all_pub;
+  // counts per minute, hour and day, transactions at their time but not after block.
+  // may already include block being applied.
+  extern ds::Rollup block_rollup;
+  extern ds::Rollup tx_rollup;
+  extern ds::Rollup command_rollup;
+
+  struct Counts {
+    size_t block, tx, account, peer, role, domain;
+  };
+
+  // order-independent part of block processing
+  struct Digest {
+    std::string bytes;
+    Sha256 hash;
+    std::vector<Sha256> tx_hash;
+    std::vector<EDKey> pubs;
+    std::vector<std::pair<Id, Id>> tx_cmds;
+  };
+
+  struct Prepared {
+    iroha::protocol::Block block;
+    Digest digest;
+  };
 
   void load();
-  void drop();
-  void addBlock(const iroha::protocol::Block &block);
+  void close();
+  // removes blocks above height and reverts their changes
+  void rollback(size_t height);
+  // changes when rollback replaces blocks, so responses for same height may differ
+  size_t rollbackCount();
+  // serializes block and fills digest, thread-safe
+  void prepare(Prepared &prepared);
+  // applies consecutive prepared blocks with one writer lock
+  void addBlocks(const std::vector<Prepared> &blocks);
 
+  Counts counts();
   size_t blockCount();
+  size_t durableBlockCount();
   size_t txCount();
   size_t accountCount();
   size_t peerCount();
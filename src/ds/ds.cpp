@@ -2,6 +2,17 @@
 #include "format/format.hpp"
 
 namespace bcx::ds {
+  Id toId(size_t value) {
+    if (value >= std::numeric_limits<Id>::max()) {
+      fatal("Id {} doesn't fit in 32 bits", value);
+    }
+    return value;
+  }
+
+  Len::Len() {
+    offset_.push_back(0);
+  }
+
   size_t Len::size() const {
     return offset_.size() - 1;
   }
@@ -34,24 +45,206 @@ namespace bcx::ds {
   }
 
   size_t Strings::size() const {
-    return len.size();
-  }
-
-  size_t Strings::size_bytes() const {
-    return len.size_bytes();
+    return views_.size();
   }
 
   std::string_view Strings::operator[](size_t i) const {
-    return {b2c(bytes.data() + len.offset(i)), len.size(i)};
+    return views_[i];
   }
 
   void Strings::push_back(const std::string_view &str) {
-    len.push_back(str.size());
-    bytes.insert(bytes.end(), c2b(str.data()), c2b(str.data()) + str.size());
+    if (blocks_.empty() || block_used_ + str.size() > blocks_.back().second) {
+      auto size = std::max(kBlockSize, str.size());
+      blocks_.emplace_back(new char[size], size);
+      block_used_ = 0;
+    }
+    auto data = blocks_.back().first.get() + block_used_;
+    std::copy(str.begin(), str.end(), data);
+    block_used_ += str.size();
+    views_.push_back({data, str.size()});
   }
 
+  // releases blocks after last kept string
   void Strings::truncate(size_t n) {
-    len.truncate(n);
-    bytes.resize(size_bytes());
+    if (n > size()) {
+      fatal("Strings::truncate invalid argument");
+    }
+    views_.resize(n);
+    if (n == 0) {
+      blocks_.clear();
+      return;
+    }
+    auto end = views_.back().data() + views_.back().size();
+    while (!(blocks_.back().first.get() <= end && end <= blocks_.back().first.get() + blocks_.back().second)) {
+      blocks_.pop_back();
+    }
+    block_used_ = end - blocks_.back().first.get();
+  }
+
+  size_t Postings::size() const {
+    return size_;
+  }
+
+  size_t Postings::back() const {
+    return last_;
+  }
+
+  void Postings::push_back(size_t value) {
+    if (size_ % kGroup == 0) {
+      groups_.emplace_back(value, deltas_.size());
+    } else {
+      for (auto delta = value - last_;; delta >>= 7) {
+        if (delta < 0x80) {
+          deltas_.push_back(delta);
+          break;
+        }
+        deltas_.push_back((delta & 0x7F) | 0x80);
+      }
+    }
+    last_ = value;
+    ++size_;
+  }
+
+  void Postings::truncate(size_t n) {
+    if (n > size_) {
+      fatal("Postings::truncate invalid argument");
+    }
+    if (n == 0) {
+      *this = {};
+      return;
+    }
+    std::array<size_t, kGroup> values;
+    auto g = (n - 1) / kGroup;
+    decode(g, values);
+    groups_.resize(g + 1);
+    deltas_.resize(groups_.back().second);
+    size_ = g * kGroup;
+    for (size_t k = 0; size_ < n; ++k) {
+      if (k == 0) {
+        ++size_;
+        last_ = values[0];
+      } else {
+        push_back(values[k]);
+      }
+    }
+  }
+
+  size_t Postings::decode(size_t g, std::array<size_t, kGroup> &values) const {
+    auto n = std::min(kGroup, size_ - g * kGroup);
+    auto p = deltas_.data() + groups_[g].second;
+    values[0] = groups_[g].first;
+    for (size_t k = 1; k < n; ++k) {
+      size_t delta = 0;
+      for (auto shift = 0;; shift += 7) {
+        auto byte = *p++;
+        delta |= size_t{byte & 0x7Fu} << shift;
+        if (byte < 0x80) {
+          break;
+        }
+      }
+      values[k] = values[k - 1] + delta;
+    }
+    return n;
+  }
+
+  uint64_t Histogram::step() const {
+    return step_;
+  }
+
+  void Histogram::add(uint64_t time, size_t n) {
+    auto bucket = time / step_;
+    if (counts_.empty()) {
+      first_ = bucket;
+    }
+    auto i = std::max(bucket, first_) - first_;
+    if (i >= counts_.size()) {
+      counts_.resize(i + 1, 0);
+    }
+    counts_.store(i, counts_[i] + n);
+  }
+
+  void Histogram::remove(uint64_t time, size_t n) {
+    auto i = std::max(time / step_, first_) - first_;
+    counts_.store(i, counts_[i] - n);
+  }
+
+  size_t Histogram::sum(uint64_t begin, uint64_t end) const {
+    auto size = counts_.size();
+    if (size == 0) {
+      return 0;
+    }
+    begin = std::max(begin, first_) - first_;
+    end = std::min(std::max(end, first_) - first_, size);
+    size_t sum = 0;
+    for (auto i = begin; i < end; ++i) {
+      sum += counts_.load(i);
+    }
+    return sum;
+  }
+
+  void Rollup::add(uint64_t time, size_t n) {
+    if (time < kMinTime || time >= kMaxTime) {
+      return;
+    }
+    minutes_.add(time, n);
+    hours_.add(time, n);
+    days_.add(time, n);
+  }
+
+  void Rollup::remove(uint64_t time, size_t n) {
+    if (time < kMinTime || time >= kMaxTime) {
+      return;
+    }
+    minutes_.remove(time, n);
+    hours_.remove(time, n);
+    days_.remove(time, n);
+  }
+
+  // coarsest histogram aligned with buckets, cost is n * step / histogram step
+  std::vector<size_t> Rollup::buckets(uint64_t begin, uint64_t step, size_t n) const {
+    auto &histogram = begin % days_.step() == 0 && step % days_.step() == 0 ? days_
+        : begin % hours_.step() == 0 && step % hours_.step() == 0          ? hours_
+                                                                          : minutes_;
+    std::vector<size_t> buckets;
+    buckets.reserve(n);
+    auto k = step / histogram.step();
+    for (auto i = begin / histogram.step(); buckets.size() < n; i += k) {
+      buckets.push_back(histogram.sum(i, i + k));
+    }
+    return buckets;
+  }
+
+  void Ngrams::add(size_t index, std::string_view str) {
+    for (size_t n = 1; n <= kMaxN; ++n) {
+      for (size_t i = 0; i + n <= str.size(); ++i) {
+        auto &postings = postings_[key(str.substr(i, n))];
+        if (postings.size() == 0 || postings.back() != index) {
+          postings.push_back(index);
+        }
+      }
+    }
+  }
+
+  void Ngrams::remove(size_t index, std::string_view str) {
+    for (size_t n = 1; n <= kMaxN; ++n) {
+      for (size_t i = 0; i + n <= str.size(); ++i) {
+        auto it = postings_.find(key(str.substr(i, n)));
+        if (it == postings_.end() || it->second.back() != index) {
+          continue;
+        }
+        it->second.truncate(it->second.size() - 1);
+        if (it->second.size() == 0) {
+          postings_.erase(it);
+        }
+      }
+    }
+  }
+
+  uint32_t Ngrams::key(std::string_view gram) {
+    uint32_t key = gram.size();
+    for (auto c : gram) {
+      key = (key << 8) | static_cast<uint8_t>(c);
+    }
+    return key;
   }
 }  // namespace bcx
@@ -1,13 +1,29 @@
 #ifndef BCX_DS_DS_HPP
 #define BCX_DS_DS_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <functional>
+#include <istream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
 #include <string_view>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 
 #include "types.hpp"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace std {
   template <typename T, size_t N>
   struct hash<array<T, N>> {
@@ -18,6 +34,318 @@ namespace std {
 }  // namespace std
 
 namespace bcx::ds {
+  template <typename T>
+  constexpr bool kRaw = std::is_trivially_copyable_v<T>;
+
+  template <typename A, typename B>
+  constexpr bool kRaw<std::pair<A, B>> = kRaw<A> && kRaw<B>;
+
+  template <typename T>
+  struct IsVector : std::false_type {};
+
+  template <typename T>
+  struct IsVector<std::vector<T>> : std::true_type {};
+
+  // narrows to Id, fatal if value doesn't fit
+  Id toId(size_t value);
+
+  template <typename T>
+  struct IsBytes : std::false_type {};
+
+  template <size_t N>
+  struct IsBytes<std::array<Byte, N>> : std::true_type {};
+
+  // binary snapshot io, structures describe their fields with `io(Io &)`
+  struct Writer {
+    static constexpr bool kRead = false;
+
+    template <typename T>
+    Writer &operator()(T &value) {
+      if constexpr (kRaw<T>) {
+        raw(&value, sizeof(T));
+      } else if constexpr (IsVector<T>::value) {
+        uint64_t size = value.size();
+        raw(&size, sizeof(size));
+        if constexpr (kRaw<typename T::value_type>) {
+          raw(value.data(), size * sizeof(typename T::value_type));
+        } else {
+          for (auto &item : value) {
+            (*this)(item);
+          }
+        }
+      } else {
+        value.io(*this);
+      }
+      return *this;
+    }
+
+    void raw(const void *data, size_t size) {
+      stream.write(static_cast<const char *>(data), size);
+    }
+
+    std::ostream &stream;
+  };
+
+  struct Reader {
+    static constexpr bool kRead = true;
+
+    template <typename T>
+    Reader &operator()(T &value) {
+      if constexpr (kRaw<T>) {
+        raw(&value, sizeof(T));
+      } else if constexpr (IsVector<T>::value) {
+        uint64_t size = 0;
+        raw(&size, sizeof(size));
+        if (size > remaining) {
+          fail();
+          size = 0;
+        }
+        value.resize(size);
+        if constexpr (kRaw<typename T::value_type>) {
+          raw(value.data(), size * sizeof(typename T::value_type));
+        } else {
+          for (auto &item : value) {
+            (*this)(item);
+          }
+        }
+      } else {
+        value.io(*this);
+      }
+      return *this;
+    }
+
+    void raw(void *data, size_t size) {
+      if (size > remaining) {
+        fail();
+        return;
+      }
+      stream.read(static_cast<char *>(data), size);
+      remaining -= size;
+      if (!stream.good()) {
+        fail();
+      }
+    }
+
+    void fail() {
+      ok = false;
+      remaining = 0;
+    }
+
+    std::istream &stream;
+    size_t remaining;
+    bool ok{true};
+  };
+
+  // append-only vector with stable element addresses, chunk k holds kFirstChunk << k elements.
+  // single writer appends, concurrent readers access elements below size they observed.
+  template <typename T>
+  class Chunked {
+    static_assert(kRaw<T>);
+    static constexpr size_t kFirstChunkBits = 10;
+    static constexpr size_t kFirstChunk = size_t{1} << kFirstChunkBits;
+    static constexpr size_t kChunks = 64 - kFirstChunkBits;
+
+   public:
+    using value_type = T;
+
+    class Iterator {
+     public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = T;
+      using difference_type = ptrdiff_t;
+      using pointer = const T *;
+      using reference = const T &;
+
+      Iterator() = default;
+      Iterator(const Chunked *chunked, size_t i) : chunked_{chunked}, i_{i} {}
+
+      reference operator*() const {
+        return (*chunked_)[i_];
+      }
+
+      reference operator[](difference_type n) const {
+        return (*chunked_)[i_ + n];
+      }
+
+      Iterator &operator++() {
+        ++i_;
+        return *this;
+      }
+
+      Iterator &operator--() {
+        --i_;
+        return *this;
+      }
+
+      Iterator operator++(int) {
+        return {chunked_, i_++};
+      }
+
+      Iterator operator--(int) {
+        return {chunked_, i_--};
+      }
+
+      Iterator &operator+=(difference_type n) {
+        i_ += n;
+        return *this;
+      }
+
+      Iterator &operator-=(difference_type n) {
+        i_ -= n;
+        return *this;
+      }
+
+      Iterator operator+(difference_type n) const {
+        return {chunked_, i_ + n};
+      }
+
+      Iterator operator-(difference_type n) const {
+        return {chunked_, i_ - n};
+      }
+
+      difference_type operator-(const Iterator &other) const {
+        return i_ - other.i_;
+      }
+
+      bool operator==(const Iterator &other) const {
+        return i_ == other.i_;
+      }
+
+      bool operator!=(const Iterator &other) const {
+        return i_ != other.i_;
+      }
+
+      bool operator<(const Iterator &other) const {
+        return i_ < other.i_;
+      }
+
+      bool operator>(const Iterator &other) const {
+        return i_ > other.i_;
+      }
+
+      bool operator<=(const Iterator &other) const {
+        return i_ <= other.i_;
+      }
+
+      bool operator>=(const Iterator &other) const {
+        return i_ >= other.i_;
+      }
+
+     private:
+      const Chunked *chunked_{nullptr};
+      size_t i_{0};
+    };
+
+    Chunked() = default;
+    Chunked(const Chunked &) = delete;
+
+    ~Chunked() {
+      for (auto &chunk : chunks_) {
+        delete[] chunk.load(std::memory_order_relaxed);
+      }
+    }
+
+    size_t size() const {
+      return size_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+      return size() == 0;
+    }
+
+    const T &operator[](size_t i) const {
+      auto [k, j] = locate(i);
+      return chunks_[k].load(std::memory_order_relaxed)[j];
+    }
+
+    T &operator[](size_t i) {
+      auto [k, j] = locate(i);
+      return chunks_[k].load(std::memory_order_relaxed)[j];
+    }
+
+    const T &back() const {
+      return (*this)[size() - 1];
+    }
+
+    T &back() {
+      return (*this)[size() - 1];
+    }
+
+    Iterator begin() const {
+      return {this, 0};
+    }
+
+    Iterator end() const {
+      return {this, size()};
+    }
+
+    void push_back(const T &value) {
+      auto n = size_.load(std::memory_order_relaxed);
+      auto [k, j] = locate(n);
+      auto chunk = chunks_[k].load(std::memory_order_relaxed);
+      if (chunk == nullptr) {
+        chunk = new T[kFirstChunk << k];
+        chunks_[k].store(chunk, std::memory_order_release);
+      }
+      chunk[j] = value;
+      size_.store(n + 1, std::memory_order_release);
+    }
+
+    // keeps allocated chunks, only for writer when readers can't observe removed elements
+    void resize(size_t n, const T &value = {}) {
+      if (n < size()) {
+        size_.store(n, std::memory_order_release);
+      }
+      while (size() < n) {
+        push_back(value);
+      }
+    }
+
+    void truncate(size_t n) {
+      resize(std::min(n, size()));
+    }
+
+    // in-place update of published element, readers of such elements use `load`
+    void store(size_t i, const T &value) {
+      __atomic_store(&(*this)[i], &value, __ATOMIC_RELEASE);
+    }
+
+    T load(size_t i) const {
+      T value;
+      __atomic_load(&(*this)[i], &value, __ATOMIC_ACQUIRE);
+      return value;
+    }
+
+    // same layout as vector
+    template <typename Io>
+    void io(Io &io) {
+      uint64_t size = this->size();
+      io.raw(&size, sizeof(size));
+      if constexpr (Io::kRead) {
+        if (size > io.remaining / sizeof(T)) {
+          io.fail();
+          size = 0;
+        }
+        resize(size);
+      }
+      for (size_t k = 0, i = 0; i < size; ++k) {
+        auto n = std::min(kFirstChunk << k, size - i);
+        io.raw(chunks_[k].load(std::memory_order_relaxed), n * sizeof(T));
+        i += n;
+      }
+    }
+
+   private:
+    static std::pair<size_t, size_t> locate(size_t i) {
+      auto p = i + kFirstChunk;
+      auto k = 63 - __builtin_clzll(p) - kFirstChunkBits;
+      return {k, p - (kFirstChunk << k)};
+    }
+
+    std::atomic<T *> chunks_[kChunks]{};
+    std::atomic_size_t size_{0};
+  };
+
   class Len {
    public:
     size_t size() const;
@@ -28,111 +356,351 @@ namespace bcx::ds {
     void push_back(size_t n);
     void truncate(size_t n);
 
+    Len();
+
+    template <typename Io>
+    void io(Io &io) {
+      io(offset_);
+      if (offset_.empty()) {
+        offset_.push_back(0);
+      }
+    }
+
    private:
-    std::vector<size_t> offset_{0};
+    Chunked<size_t> offset_;
   };
 
-  struct Strings {
+  // strings in append-only byte blocks, views stay valid while strings are appended
+  class Strings {
+   public:
     using value_type = std::string_view;
 
     size_t size() const;
-    size_t size_bytes() const;
     std::string_view operator[](size_t i) const;
     void push_back(const std::string_view &str);
     void truncate(size_t n);
 
-    std::vector<Byte> bytes;
-    Len len;
+    // same layout as lengths and concatenated bytes
+    template <typename Io>
+    void io(Io &io) {
+      Len len;
+      std::vector<Byte> bytes;
+      if constexpr (!Io::kRead) {
+        for (auto str : views_) {
+          len.push_back(str.size());
+          bytes.insert(bytes.end(), c2b(str.data()), c2b(str.data()) + str.size());
+        }
+      }
+      io(len)(bytes);
+      if constexpr (Io::kRead) {
+        truncate(0);
+        for (size_t i = 0; i < len.size(); ++i) {
+          push_back({b2c(bytes.data() + len.offset(i)), len.size(i)});
+        }
+      }
+    }
+
+   private:
+    static constexpr size_t kBlockSize = size_t{64} << 10;
+
+    Chunked<std::string_view> views_;
+    std::vector<std::pair<std::unique_ptr<char[]>, size_t>> blocks_;
+    size_t block_used_{0};
   };
 
-  template <bool copy, typename Vector>
-  struct Indirect {
-    using T = typename Vector::value_type;
+  // ascending values, delta varint coded in groups, group first values allow binary search
+  class Postings {
+   public:
+    size_t size() const;
+    size_t back() const;
+    void push_back(size_t value);
+    void truncate(size_t n);
 
-    Indirect(const Vector &vector) : vector{vector} {}
+    // calls f for values in [begin, end), descending if reverse, while f returns true
+    template <typename F>
+    void scan(size_t begin, size_t end, bool reverse, F &&f) const {
+      if (begin >= end || groups_.empty()) {
+        return;
+      }
+      std::array<size_t, kGroup> values;
+      if (reverse) {
+        size_t g = std::lower_bound(groups_.begin(), groups_.end(), end, [](auto &group, size_t x) { return group.first < x; }) - groups_.begin();
+        while (g-- > 0) {
+          auto n = decode(g, values);
+          for (auto k = n; k-- > 0;) {
+            if (values[k] >= end) {
+              continue;
+            }
+            if (values[k] < begin || !f(values[k])) {
+              return;
+            }
+          }
+        }
+      } else {
+        size_t g = std::upper_bound(groups_.begin(), groups_.end(), begin, [](size_t x, auto &group) { return x < group.first; }) - groups_.begin();
+        for (g = g == 0 ? 0 : g - 1; g < groups_.size(); ++g) {
+          auto n = decode(g, values);
+          for (size_t k = 0; k < n; ++k) {
+            if (values[k] < begin) {
+              continue;
+            }
+            if (values[k] >= end || !f(values[k])) {
+              return;
+            }
+          }
+        }
+      }
+    }
 
-    std::conditional_t<copy, T, const T &> get(size_t index) const {
-      if (index == key_index) {
-        if constexpr (copy) {
-          return *key;
-        } else {
-          return key->get();
+   private:
+    static constexpr size_t kGroup = 64;
+
+    size_t decode(size_t g, std::array<size_t, kGroup> &values) const;
+
+    // first value and offset of following deltas
+    std::vector<std::pair<size_t, size_t>> groups_;
+    std::vector<uint8_t> deltas_;
+    size_t size_{0};
+    size_t last_{0};
+  };
+
+  // event counts per time bucket from first event, earlier events go to first bucket.
+  // counts are updated in place, readers sum them without locks.
+  class Histogram {
+   public:
+    Histogram(uint64_t step) : step_{step} {}
+
+    uint64_t step() const;
+    void add(uint64_t time, size_t n);
+    // undoes add
+    void remove(uint64_t time, size_t n);
+    // events in buckets [begin, end)
+    size_t sum(uint64_t begin, uint64_t end) const;
+
+    template <typename Io>
+    void io(Io &io) {
+      io(first_)(counts_);
+    }
+
+   private:
+    uint64_t step_;
+    uint64_t first_{0};
+    Chunked<size_t> counts_;
+  };
+
+  // event counts per minute, hour and day of unix time in milliseconds.
+  // times outside years 2000 to 2100 aren't counted, genesis block without time would make tables dense from 1970.
+  class Rollup {
+   public:
+    void add(uint64_t time, size_t n);
+    void remove(uint64_t time, size_t n);
+    // counts in `n` buckets of `step` from `begin`, both multiples of minute
+    std::vector<size_t> buckets(uint64_t begin, uint64_t step, size_t n) const;
+
+    template <typename Io>
+    void io(Io &io) {
+      io(minutes_)(hours_)(days_);
+    }
+
+   private:
+    static constexpr uint64_t kMinTime = 946684800000;
+    static constexpr uint64_t kMaxTime = 4102444800000;
+
+    Histogram minutes_{60000}, hours_{3600000}, days_{86400000};
+  };
+
+  // strings by their substrings of up to 3 bytes, for substring search
+  class Ngrams {
+   public:
+    void add(size_t index, std::string_view str);
+    // undoes add of largest index
+    void remove(size_t index, std::string_view str);
+
+    // calls f for ascending indices in [begin, end) of strings which may contain str, while f returns true
+    template <typename F>
+    void candidates(std::string_view str, size_t begin, size_t end, F &&f) const {
+      const Postings *rarest = nullptr;
+      auto n = std::min(str.size(), kMaxN);
+      for (size_t i = 0; i + n <= str.size(); ++i) {
+        auto it = postings_.find(key(str.substr(i, n)));
+        if (it == postings_.end()) {
+          return;
         }
+        if (rarest == nullptr || it->second.size() < rarest->size()) {
+          rarest = &it->second;
+        }
+      }
+      if (rarest != nullptr) {
+        rarest->scan(begin, end, false, f);
       }
-      return vector[index];
     }
 
-    struct HashEq {
-      using Set = std::unordered_set<size_t, HashEq, HashEq>;
+   private:
+    static constexpr size_t kMaxN = 3;
 
-      HashEq(const Indirect &indirect) : indirect{indirect} {}
+    static uint32_t key(std::string_view gram);
 
-      auto set() {
-        return Set{0, *this, *this};
+    std::unordered_map<uint32_t, Postings> postings_;
+  };
+
+  // open addressing index of vector elements, probed by groups of 16 one byte fingerprints.
+  // vector is read without lock, index lookups are guarded.
+  template <typename Vector>
+  class Hashed {
+   public:
+    using T = typename Vector::value_type;
+
+    size_t size() const {
+      return vector_.size();
+    }
+
+    size_t capacity() const {
+      std::shared_lock lock{mutex_};
+      return slots_.size();
+    }
+
+    decltype(auto) operator[](size_t index) const {
+      return vector_[index];
+    }
+
+    std::optional<size_t> find(const T &value) const {
+      auto h = hash(value);
+      std::shared_lock lock{mutex_};
+      if (slots_.empty()) {
+        return std::nullopt;
       }
+      auto group_mask = slots_.size() / kGroup - 1;
+      auto g = (h >> 7) & group_mask;
+      for (size_t step = 1;; ++step) {
+        auto ctrl = ctrl_.data() + g * kGroup;
+        for (auto bits = match(ctrl, h & 0x7F); bits != 0; bits &= bits - 1) {
+          auto index = slots_[g * kGroup + __builtin_ctz(bits)];
+          if (vector_[index] == value) {
+            return index;
+          }
+        }
+        if (match(ctrl, kEmpty) != 0) {
+          return std::nullopt;
+        }
+        g = (g + step) & group_mask;
+      }
+    }
 
-      auto operator()(size_t index) const {
-        return std::hash<T>{}(indirect.get(index));
+    void push_back(const T &value) {
+      auto index = toId(vector_.size());
+      vector_.push_back(value);
+      std::unique_lock lock{mutex_};
+      if ((index + 1) * 8 > slots_.size() * 7) {
+        rehash(std::max(kGroup, slots_.size() * 2), index);
       }
+      insert(index);
+    }
 
-      auto operator()(size_t lhs, size_t rhs) const {
-        return indirect.get(lhs) == indirect.get(rhs);
+    // removed elements were inserted last, so probe sequences of remaining ones stay intact
+    void truncate(size_t n) {
+      std::unique_lock lock{mutex_};
+      for (auto index = vector_.size(); index > n; --index) {
+        erase(index - 1);
       }
+      vector_.truncate(n);
+    }
 
-      const Indirect &indirect;
-    };
+    template <typename Io>
+    void io(Io &io) {
+      io(vector_);
+      if constexpr (Io::kRead) {
+        std::unique_lock lock{mutex_};
+        auto capacity = kGroup;
+        while (vector_.size() * 8 > capacity * 7) {
+          capacity *= 2;
+        }
+        rehash(capacity, vector_.size());
+      }
+    }
 
-    auto find(const typename HashEq::Set &set, const T &value) {
-      if constexpr (copy) {
-        key = value;
+   private:
+    static constexpr size_t kGroup = 16;
+    static constexpr uint8_t kEmpty = 0x80;
+
+    // digests and keys are uniform, their bytes are the hash
+    static size_t hash(const T &value) {
+      if constexpr (IsBytes<T>::value) {
+        static_assert(sizeof(T) >= sizeof(size_t));
+        size_t h;
+        std::memcpy(&h, value.data(), sizeof(h));
+        return h;
       } else {
-        key = std::cref(value);
+        return std::hash<T>{}(value);
       }
-      auto it = set.find(key_index);
-      std::optional<size_t> result;
-      if (it != set.end()) {
-        result = *it;
-      }
-      key.reset();
-      return result;
     }
 
-    struct Hashed {
-      Vector vector;
-      Indirect indirect{vector};
-      HashEq hash_eq{indirect};
-      typename HashEq::Set set{hash_eq.set()};
-
-      auto size() const {
-        return vector.size();
+    // bit per fingerprint equal to `byte` in group
+    static uint32_t match(const uint8_t *ctrl, uint8_t byte) {
+#ifdef __SSE2__
+      auto group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(byte))));
+#else
+      uint32_t bits = 0;
+      for (size_t i = 0; i < kGroup; ++i) {
+        bits |= uint32_t{ctrl[i] == byte} << i;
       }
+      return bits;
+#endif
+    }
 
-      decltype(auto) operator[](size_t index) const { 
-        return vector[index];
+    void insert(Id index) {
+      auto h = hash(vector_[index]);
+      auto group_mask = slots_.size() / kGroup - 1;
+      auto g = (h >> 7) & group_mask;
+      for (size_t step = 1;; ++step) {
+        if (auto empty = match(ctrl_.data() + g * kGroup, kEmpty)) {
+          auto i = g * kGroup + __builtin_ctz(empty);
+          ctrl_[i] = h & 0x7F;
+          slots_[i] = index;
+          return;
+        }
+        g = (g + step) & group_mask;
       }
+    }
 
-      auto find(const T &value) {
-        return indirect.find(set, value);
+    void erase(size_t index) {
+      auto h = hash(vector_[index]);
+      auto group_mask = slots_.size() / kGroup - 1;
+      auto g = (h >> 7) & group_mask;
+      for (size_t step = 1;; ++step) {
+        auto ctrl = ctrl_.data() + g * kGroup;
+        for (auto bits = match(ctrl, h & 0x7F); bits != 0; bits &= bits - 1) {
+          auto i = g * kGroup + __builtin_ctz(bits);
+          if (slots_[i] == index) {
+            ctrl_[i] = kEmpty;
+            return;
+          }
+        }
+        g = (g + step) & group_mask;
       }
+    }
 
-      void push_back(const T &value) {
-        auto index = vector.size();
-        vector.push_back(value);
-        set.insert(index);
+    // indexes first n elements
+    void rehash(size_t capacity, size_t n) {
+      ctrl_.assign(capacity, kEmpty);
+      slots_.assign(capacity, 0);
+      for (size_t i = 0; i < n; ++i) {
+        insert(toId(i));
       }
-    };
+    }
 
-    static constexpr size_t key_index{std::numeric_limits<size_t>::max()};
-    const Vector &vector;
-    std::optional<std::conditional_t<copy, T, std::reference_wrapper<const T>>> key;
+    Vector vector_;
+    std::vector<uint8_t> ctrl_;
+    std::vector<Id> slots_;
+    mutable std::shared_mutex mutex_;
   };
 
   template <typename T>
   struct Linked {
-    static constexpr size_t null = std::numeric_limits<size_t>::max();
+    static constexpr Id null = std::numeric_limits<Id>::max();
 
-    auto add(const T &value, size_t next = null) {
-      size_t i = nodes.size();
+    auto add(const T &value, Id next = null) {
+      auto i = toId(nodes.size());
       nodes.push_back({value, next});
       return i;
     }
@@ -151,8 +719,8 @@ namespace bcx::ds {
         return linked.nodes[head].first;
       }
 
-      Linked &linked;
-      size_t head;
+      const Linked &linked;
+      Id head;
     };
 
     struct Range {
@@ -167,27 +735,149 @@ namespace bcx::ds {
       const Iterator iterator;
     };
 
-    auto range(size_t head) {
+    auto range(Id head) const {
       return Range{{*this, head}};
     }
 
+    // heads are replaced atomically after node is appended
     struct Vector {
       void add(size_t index, const T &value) {
         if (index >= heads.size()) {
           heads.resize(index + 1, null);
         }
-        heads[index] = linked.add(value, heads[index]);
+        heads.store(index, linked.add(value, heads[index]));
       }
 
-      auto range(size_t index) {
-        return linked.range(index < heads.size() ? heads[index] : null);
+      // undoes last add, which was to index
+      void pop(size_t index) {
+        auto head = heads[index];
+        heads.store(index, linked.nodes[head].second);
+        linked.nodes.truncate(head);
       }
 
-      std::vector<size_t> heads;
+      auto range(size_t index) const {
+        return linked.range(index < heads.size() ? heads.load(index) : null);
+      }
+
+      template <typename Io>
+      void io(Io &io) {
+        io(heads)(linked);
+      }
+
+      Chunked<Id> heads;
       Linked<T> linked;
     };
 
-    std::vector<std::pair<T, size_t>> nodes;
+    template <typename Io>
+    void io(Io &io) {
+      io(nodes);
+    }
+
+    Chunked<std::pair<T, Id>> nodes;
+  };
+
+  // values grouped by index in contiguous storage, indices are added in non-decreasing order.
+  // only last index is appended to, readers of earlier indices see them complete.
+  template <typename T>
+  class Csr {
+   public:
+    struct Range {
+      auto begin() const {
+        return begin_;
+      }
+
+      auto end() const {
+        return end_;
+      }
+
+      typename Chunked<T>::Iterator begin_, end_;
+    };
+
+    size_t size_values() const {
+      return values_.size();
+    }
+
+    void add(size_t index, const T &value) {
+      while (ends_.size() <= index) {
+        ends_.push_back(toId(values_.size()));
+      }
+      values_.push_back(value);
+      ends_.store(index, toId(values_.size()));
+    }
+
+    // keeps first n indices
+    void truncate(size_t n) {
+      if (n < ends_.size()) {
+        ends_.truncate(n);
+        values_.truncate(n == 0 ? 0 : ends_[n - 1]);
+      }
+    }
+
+    Range range(size_t index) const {
+      if (index >= ends_.size()) {
+        return {values_.begin(), values_.begin()};
+      }
+      auto begin = index == 0 ? 0 : ends_.load(index - 1);
+      return {values_.begin() + begin, values_.begin() + ends_.load(index)};
+    }
+
+    template <typename Io>
+    void io(Io &io) {
+      io(ends_)(values_);
+    }
+
+   private:
+    Chunked<Id> ends_;
+    Chunked<T> values_;
+  };
+
+  // map bounded by total size of values, evicts least recently used
+  template <typename K, typename V>
+  class Lru {
+   public:
+    Lru(size_t capacity) : capacity_{capacity} {}
+
+    const V *get(const K &key) {
+      auto it = index_.find(key);
+      if (it == index_.end()) {
+        return nullptr;
+      }
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return &it->second->value;
+    }
+
+    void put(const K &key, V value, size_t size) {
+      if (size > capacity_ || index_.count(key) != 0) {
+        return;
+      }
+      entries_.push_front({key, std::move(value), size});
+      index_.emplace(key, entries_.begin());
+      size_ += size;
+      while (size_ > capacity_) {
+        auto &entry = entries_.back();
+        size_ -= entry.size;
+        index_.erase(entry.key);
+        entries_.pop_back();
+      }
+    }
+
+    void clear() {
+      index_.clear();
+      entries_.clear();
+      size_ = 0;
+    }
+
+   private:
+    struct Entry {
+      K key;
+      V value;
+      size_t size;
+    };
+
+    std::list<Entry> entries_;
+    std::unordered_map<K, typename std::list<Entry>::iterator> index_;
+    size_t size_{0};
+    size_t capacity_;
   };
 }  // namespace bcx::ds
 
@@ -0,0 +1,60 @@
+#include <array>
+#include <cstring>
+
+#include "format/format.hpp"
+
+#ifdef __x86_64__
+#define BCX_CRC32C_X86
+#include <immintrin.h>
+#endif
+
+namespace bcx::format {
+  namespace {
+    constexpr uint32_t kPoly = 0x82f63b78;
+
+    constexpr auto kTable = [] {
+      std::array<uint32_t, 256> table{};
+      for (uint32_t i = 0; i < table.size(); ++i) {
+        auto crc = i;
+        for (auto j = 0; j < 8; ++j) {
+          crc = crc & 1 ? (crc >> 1) ^ kPoly : crc >> 1;
+        }
+        table[i] = crc;
+      }
+      return table;
+    }();
+
+    uint32_t crcTable(uint32_t crc, const Byte *ptr, size_t size) {
+      for (; size != 0; --size) {
+        crc = kTable[(crc ^ *ptr++) & 0xff] ^ (crc >> 8);
+      }
+      return crc;
+    }
+
+#ifdef BCX_CRC32C_X86
+    __attribute__((target("sse4.2"))) uint32_t crcSse42(uint32_t crc, const Byte *ptr, size_t size) {
+      uint64_t crc64 = crc;
+      for (; size >= 8; size -= 8, ptr += 8) {
+        uint64_t word;
+        std::memcpy(&word, ptr, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+      }
+      crc = static_cast<uint32_t>(crc64);
+      for (; size != 0; --size) {
+        crc = _mm_crc32_u8(crc, *ptr++);
+      }
+      return crc;
+    }
+#endif
+  }  // namespace
+
+  uint32_t crc32c(std::string_view bytes) {
+#ifdef BCX_CRC32C_X86
+    static const bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (sse42) {
+      return ~crcSse42(~0u, c2b(bytes.data()), bytes.size());
+    }
+#endif
+    return ~crcTable(~0u, c2b(bytes.data()), bytes.size());
+  }
+}  // namespace bcx::format
@@ -1,12 +1,16 @@
-#include <ed25519/ed25519/sha256.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/util/json_util.h>
 #include <google/protobuf/util/time_util.h>
 #include <boost/algorithm/hex.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cstdlib>
 #include <fstream>
+#include <thread>
 
 #include "db/db.hpp"
 #include "ds/ds.hpp"
@@ -33,12 +37,6 @@ namespace bcx {
       return res;
     }
 
-    Sha256 sha256(const std::string &bytes) {
-      Sha256 res;
-      ::sha256(res.data(), c2b(bytes.data()), bytes.size());
-      return res;
-    }
-
     std::string domainOf(const std::string &account) {
       return account.substr(account.find_first_of('@') + 1);
     }
@@ -63,8 +61,24 @@ namespace bcx {
       return res;
     }
 
-    std::vector<Byte> readBytes(const std::string &path) {
-      return read<std::vector<Byte>>(path);
+    Mapped mapBytes(const std::string &path) {
+      Mapped res;
+      auto fd = ::open(path.c_str(), O_RDONLY);
+      if (fd == -1) {
+        return res;
+      }
+      struct stat st;
+      if (::fstat(fd, &st) == 0 && st.st_size != 0) {
+        auto size = static_cast<size_t>(st.st_size);
+        auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+          fatal("Can't map {}", path);
+        }
+        res.bytes = {static_cast<const char *>(ptr), size};
+        res.owner = std::shared_ptr<const void>{ptr, [size](const void *ptr) { ::munmap(const_cast<void *>(ptr), size); }};
+      }
+      ::close(fd);
+      return res;
     }
 
     std::string readText(const std::string &path) {
@@ -109,11 +123,18 @@ namespace bcx {
       google::protobuf::io::CodedInputStream stream;
     };
 
+    // CodedInputStream positions are int, bytes are split in windows below 2 GiB
     void splitPb(ds::Len &len, std::string_view bytes, int field) {
-      len = ds::Len{};
-      Pb pb{bytes};
-      while (pb.next(field)) {
-        len.push_back(pb.stream.CurrentPosition() - len.size_bytes());
+      len.truncate(0);
+      while (len.size_bytes() < bytes.size()) {
+        auto begin = len.size_bytes();
+        Pb pb{bytes.substr(begin, std::numeric_limits<int>::max())};
+        while (pb.next(field)) {
+          len.push_back(begin + pb.stream.CurrentPosition() - len.size_bytes());
+        }
+        if (len.size_bytes() == begin) {
+          break;
+        }
       }
     }
 
@@ -149,25 +170,30 @@ namespace bcx {
       return std::nullopt;
     }
 
-    void getTxCmd(std::vector<std::pair<size_t, size_t>> &result, std::string_view block) {
-      std::string_view block_v1, block_payload, tx, tx_payload, tx_reduced_payload, cmd;
-      Pb{block}.next(iroha::protocol::Block::kBlockV1FieldNumber, block_v1);
-      Pb{block_v1}.next(iroha::protocol::Block_v1::kPayloadFieldNumber, block_payload);
-      Pb pb_block{block_payload};
+    bool blockSpans(BlockSpans &spans, std::string_view block) {
+      std::string_view block_v1, tx, tx_payload, cmd;
+      spans.txs.clear();
+      if (!Pb{block}.next(iroha::protocol::Block::kBlockV1FieldNumber, block_v1)
+          || !Pb{block_v1}.next(iroha::protocol::Block_v1::kPayloadFieldNumber, spans.payload)) {
+        return false;
+      }
+      Pb pb_block{spans.payload};
       while (pb_block.next(iroha::protocol::Block_v1_Payload::kTransactionsFieldNumber, tx)) {
-        Pb{tx}.next(iroha::protocol::Transaction::kPayloadFieldNumber, tx_payload);
-        Pb{tx}.next(iroha::protocol::Transaction_Payload::kReducedPayloadFieldNumber, tx_reduced_payload);
-        Pb pb_tx{tx_reduced_payload};
-        std::string_view tx_cmd;
+        auto &tx_spans = spans.txs.emplace_back();
+        if (!Pb{tx}.next(iroha::protocol::Transaction::kPayloadFieldNumber, tx_payload)
+            || !Pb{tx_payload}.next(iroha::protocol::Transaction_Payload::kReducedPayloadFieldNumber, tx_spans.reduced_payload)) {
+          return false;
+        }
+        // commands are leading fields of reduced payload, span keeps their tags
+        auto begin = tx_spans.reduced_payload.data();
+        auto end = begin;
+        Pb pb_tx{tx_spans.reduced_payload};
         while (pb_tx.next(iroha::protocol::Transaction_Payload_ReducedPayload::kCommandsFieldNumber, cmd)) {
-          if (!tx_cmd.data()) {
-            tx_cmd = cmd;
-          } else {
-            tx_cmd = {tx_cmd.data(), tx_cmd.size() + cmd.size()};
-          }
+          end = cmd.data() + cmd.size();
         }
-        result.push_back({tx_cmd.data() - block.data(), tx_cmd.size()});
+        tx_spans.commands = {begin, static_cast<size_t>(end - begin)};
       }
+      return true;
     }
 
     std::string txCmdJson(std::string_view bytes) {
@@ -218,6 +244,19 @@ namespace bcx {
     return value;
   }
 
+  inline size_t getenvSize(const char *name, size_t fallback) {
+    auto value = std::getenv(name);
+    if (!value) {
+      return fallback;
+    }
+    try {
+      return std::stoul(value);
+    } catch (const std::logic_error &) {
+      fatal("Invalid {}={}", name, value);
+      return fallback;
+    }
+  }
+
   void Config::load() {
     auto log_level = getenv("LOG_LEVEL", "info");
     if (!setLogLevel(log_level)) {
@@ -234,6 +273,8 @@ namespace bcx {
           getenv("IROHA_HOST"),
           getenv("IROHA_ACCOUNT"),
           *iroha_account_key,
+          std::max<size_t>(getenvSize("IROHA_MAX_IN_FLIGHT", 64), 1),
+          std::max<size_t>(getenvSize("IROHA_REORDER_BLOCKS", 1024), 1),
       };
     }
 
@@ -241,7 +282,24 @@ namespace bcx {
     if (!boost::filesystem::is_directory(data_dir)) {
       fatal("DATA_DIR is not a directory");
     }
-    block_cache_path = data_dir.append("block.cache").string();
+    block_cache_path = (data_dir / "block.cache").string();
+    blocks_path = (data_dir / "blocks").string();
+    snapshot_path = (data_dir / "db.snapshot").string();
+    snapshot_blocks = getenvSize("SNAPSHOT_BLOCKS", 100000);
+
+    load_threads = getenvSize("LOAD_THREADS", std::thread::hardware_concurrency());
+    if (load_threads == 0) {
+      load_threads = 1;
+    }
+    hash_verify_sample = getenvSize("HASH_VERIFY_SAMPLE", 1024);
+    verify_block_cache = getenv("VERIFY_BLOCK_CACHE", "1") == "1";
+    durable_blocks = std::max<size_t>(getenvSize("DURABLE_BLOCKS", 256), 1);
+    durable_ms = getenvSize("DURABLE_MS", 1000);
+    http_threads = std::max<size_t>(getenvSize("HTTP_THREADS", std::thread::hardware_concurrency()), 1);
+    admin_port = getenvSize("ADMIN_PORT", 4001);
+    gql_cache_bytes = getenvSize("GQL_CACHE_BYTES", size_t{64} << 20);
+    gql_document_cache = getenvSize("GQL_DOCUMENT_CACHE", 1024);
+    gql_fast = getenv("GQL_FAST", "1") == "1";
   }
 
   bool Config::disable_sync() const {
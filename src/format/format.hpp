@@ -2,6 +2,7 @@
 #define BCX_FORMAT_FORMAT_HPP
 
 #include <spdlog/spdlog.h>
+#include <memory>
 #include <optional>
 
 #include "types.hpp"
@@ -30,7 +31,22 @@ namespace bcx {
       return hex(std::data(bytes), std::size(bytes));
     }
 
-    Sha256 sha256(const std::string &bytes);
+    Sha256 sha256(std::string_view bytes);
+
+    // hashes `n` buffers at once, using the fastest engine supported by cpu
+    void sha256(Sha256 *out, const std::string_view *in, size_t n);
+
+    struct Sha256Engine {
+      const char *name;
+      size_t min_batch;
+      bool (*supported)();
+      void (*hash)(Sha256 *out, const std::string_view *in, size_t n);
+    };
+
+    // in order of preference, scalar fallback is last
+    const std::vector<Sha256Engine> &sha256Engines();
+
+    uint32_t crc32c(std::string_view bytes);
 
     std::string domainOf(const std::string &account);
 
@@ -38,7 +54,12 @@ namespace bcx {
 
     Sha256 blockHash(const iroha::protocol::Block &block);
 
-    std::vector<Byte> readBytes(const std::string &path);
+    struct Mapped {
+      std::string_view bytes;
+      std::shared_ptr<const void> owner;
+    };
+
+    Mapped mapBytes(const std::string &path);
 
     std::string readText(const std::string &path);
 
@@ -54,7 +75,17 @@ namespace bcx {
 
     std::optional<uint64_t> isoToTime(const std::string &str);
 
-    void getTxCmd(std::vector<std::pair<size_t, size_t>> &result, std::string_view block);
+    struct TxSpans {
+      std::string_view reduced_payload;
+      std::string_view commands;
+    };
+
+    struct BlockSpans {
+      std::string_view payload;
+      std::vector<TxSpans> txs;
+    };
+
+    bool blockSpans(BlockSpans &spans, std::string_view block);
 
     std::string txCmdJson(std::string_view bytes);
   }  // namespace format
@@ -74,6 +105,10 @@ namespace bcx {
       std::string host;
       std::string account;
       EDKey private_key;
+      // cap of GetBlock calls in flight during catch up
+      size_t max_in_flight;
+      // blocks fetched ahead of next one to apply
+      size_t reorder_blocks;
     };
 
     void load();
@@ -81,6 +116,20 @@ namespace bcx {
 
     std::optional<Iroha> iroha;
     std::string block_cache_path;
+    std::string blocks_path;
+    std::string snapshot_path;
+    // synced blocks between snapshots, 0 saves only on load and close
+    size_t snapshot_blocks;
+    size_t load_threads;
+    size_t hash_verify_sample;
+    bool verify_block_cache;
+    size_t durable_blocks;
+    size_t durable_ms;
+    size_t http_threads;
+    size_t admin_port;
+    size_t gql_cache_bytes;
+    size_t gql_document_cache;
+    bool gql_fast;
   };
 
   extern Config config;
@@ -0,0 +1,265 @@
+#include <ed25519/ed25519/sha256.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "format/format.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BCX_SHA256_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace bcx::format {
+  namespace {
+    constexpr size_t kBlock = 64;
+
+    constexpr uint32_t kInit[8]{
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+    alignas(16) constexpr uint32_t kRound[64]{
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    // message split into full blocks read in place and 1-2 padded tail blocks
+    struct Padded {
+      Padded(std::string_view bytes) : data{c2b(bytes.data())}, full{bytes.size() / kBlock} {
+        auto rest = bytes.size() % kBlock;
+        blocks = full + (rest + 9 > kBlock ? 2 : 1);
+        std::memset(tail, 0, sizeof(tail));
+        if (rest != 0) {
+          std::memcpy(tail, data + full * kBlock, rest);
+        }
+        tail[rest] = 0x80;
+        uint64_t bits = bytes.size() * 8;
+        auto end = tail + (blocks - full) * kBlock;
+        for (auto i = 1; i <= 8; ++i, bits >>= 8) {
+          end[-i] = static_cast<Byte>(bits);
+        }
+      }
+
+      const Byte *block(size_t i) const {
+        return i < full ? data + i * kBlock : tail + (i - full) * kBlock;
+      }
+
+      const Byte *data;
+      size_t full, blocks;
+      Byte tail[2 * kBlock];
+    };
+
+    void store(Sha256 &out, const uint32_t *state) {
+      for (auto i = 0; i < 8; ++i) {
+        out[i * 4] = state[i] >> 24;
+        out[i * 4 + 1] = state[i] >> 16;
+        out[i * 4 + 2] = state[i] >> 8;
+        out[i * 4 + 3] = state[i];
+      }
+    }
+
+    bool always() {
+      return true;
+    }
+
+    void hashScalar(Sha256 *out, const std::string_view *in, size_t n) {
+      for (auto i = 0u; i < n; ++i) {
+        ::sha256(out[i].data(), c2b(in[i].data()), in[i].size());
+      }
+    }
+
+#ifdef BCX_SHA256_X86
+    bool cpuShaNi() {
+      unsigned a, b, c, d;
+      return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_SHA) && __builtin_cpu_supports("sse4.1");
+    }
+
+    bool cpuAvx2() {
+      return __builtin_cpu_supports("avx2");
+    }
+
+    __attribute__((target("sha,sse4.1"))) void compressShaNi(uint32_t *state, const Byte *block) {
+      const auto kSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+      auto tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0xB1);
+      auto state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4)), 0x1B);
+      auto state0 = _mm_alignr_epi8(tmp, state1, 8);
+      state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+      auto save0 = state0, save1 = state1;
+      __m128i w[4];
+      for (auto i = 0; i < 16; ++i) {
+        auto &wi = w[i % 4];
+        if (i < 4) {
+          wi = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16)), kSwap);
+        } else {
+          auto &w1 = w[(i - 1) % 4];
+          auto x = _mm_sha256msg1_epu32(wi, w[(i - 3) % 4]);
+          x = _mm_add_epi32(x, _mm_alignr_epi8(w1, w[(i - 2) % 4], 4));
+          wi = _mm_sha256msg2_epu32(x, w1);
+        }
+        auto msg = _mm_add_epi32(wi, _mm_load_si128(reinterpret_cast<const __m128i *>(kRound + i * 4)));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+      }
+      state0 = _mm_add_epi32(state0, save0);
+      state1 = _mm_add_epi32(state1, save1);
+      tmp = _mm_shuffle_epi32(state0, 0x1B);
+      state1 = _mm_shuffle_epi32(state1, 0xB1);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(state), _mm_blend_epi16(tmp, state1, 0xF0));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+    }
+
+    void hashShaNi(Sha256 *out, const std::string_view *in, size_t n) {
+      for (auto i = 0u; i < n; ++i) {
+        Padded padded{in[i]};
+        uint32_t state[8];
+        std::copy(std::begin(kInit), std::end(kInit), state);
+        for (auto j = 0u; j < padded.blocks; ++j) {
+          compressShaNi(state, padded.block(j));
+        }
+        store(out[i], state);
+      }
+    }
+
+#define BCX_TARGET_AVX2 __attribute__((target("avx2")))
+
+    BCX_TARGET_AVX2 inline __m256i rotr(__m256i x, int n) {
+      return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+    }
+
+    BCX_TARGET_AVX2 inline __m256i add(__m256i a, __m256i b) {
+      return _mm256_add_epi32(a, b);
+    }
+
+    BCX_TARGET_AVX2 inline __m256i xor3(__m256i a, __m256i b, __m256i c) {
+      return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+    }
+
+    // one block for each of 8 lanes, lanes outside `mask` keep their state
+    BCX_TARGET_AVX2 void compressAvx2(__m256i *state, const Byte *const *blocks, __m256i mask) {
+      const auto kSwap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                         12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+      __m256i w[64];
+      for (auto t = 0; t < 16; ++t) {
+        uint32_t lane[8];
+        for (auto l = 0; l < 8; ++l) {
+          std::memcpy(&lane[l], blocks[l] + t * 4, 4);
+        }
+        w[t] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane)), kSwap);
+      }
+      for (auto t = 16; t < 64; ++t) {
+        auto s0 = xor3(rotr(w[t - 15], 7), rotr(w[t - 15], 18), _mm256_srli_epi32(w[t - 15], 3));
+        auto s1 = xor3(rotr(w[t - 2], 17), rotr(w[t - 2], 19), _mm256_srli_epi32(w[t - 2], 10));
+        w[t] = add(add(w[t - 16], s0), add(w[t - 7], s1));
+      }
+      auto a = state[0], b = state[1], c = state[2], d = state[3];
+      auto e = state[4], f = state[5], g = state[6], h = state[7];
+      for (auto t = 0; t < 64; ++t) {
+        auto s1 = xor3(rotr(e, 6), rotr(e, 11), rotr(e, 25));
+        auto ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        auto t1 = add(add(add(h, s1), add(ch, _mm256_set1_epi32(kRound[t]))), w[t]);
+        auto s0 = xor3(rotr(a, 2), rotr(a, 13), rotr(a, 22));
+        auto maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        auto t2 = add(s0, maj);
+        h = g;
+        g = f;
+        f = e;
+        e = add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = add(t1, t2);
+      }
+      __m256i next[8]{a, b, c, d, e, f, g, h};
+      for (auto i = 0; i < 8; ++i) {
+        state[i] = _mm256_blendv_epi8(state[i], add(state[i], next[i]), mask);
+      }
+    }
+
+    // 8 messages per pass, grouped by block count to keep lanes busy
+    BCX_TARGET_AVX2 void hashAvx2(Sha256 *out, const std::string_view *in, size_t n) {
+      std::vector<size_t> order(n);
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](size_t l, size_t r) { return in[l].size() < in[r].size(); });
+      std::vector<Padded> padded;
+      padded.reserve(8);
+      for (auto group = 0u; group < n; group += 8) {
+        auto lanes = std::min<size_t>(8, n - group);
+        padded.clear();
+        for (auto l = 0u; l < lanes; ++l) {
+          padded.emplace_back(in[order[group + l]]);
+        }
+        __m256i state[8];
+        for (auto i = 0; i < 8; ++i) {
+          state[i] = _mm256_set1_epi32(kInit[i]);
+        }
+        size_t blocks = 0;
+        for (auto &p : padded) {
+          blocks = std::max(blocks, p.blocks);
+        }
+        for (auto j = 0u; j < blocks; ++j) {
+          const Byte *block[8];
+          int32_t active[8];
+          for (auto l = 0u; l < 8; ++l) {
+            auto on = l < lanes && j < padded[l].blocks;
+            block[l] = on ? padded[l].block(j) : padded[0].tail;
+            active[l] = on ? -1 : 0;
+          }
+          compressAvx2(state, block, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(active)));
+        }
+        alignas(32) uint32_t words[8][8];
+        for (auto i = 0; i < 8; ++i) {
+          _mm256_store_si256(reinterpret_cast<__m256i *>(words[i]), state[i]);
+        }
+        for (auto l = 0u; l < lanes; ++l) {
+          uint32_t lane[8];
+          for (auto i = 0; i < 8; ++i) {
+            lane[i] = words[i][l];
+          }
+          store(out[order[group + l]], lane);
+        }
+      }
+    }
+#endif
+
+    const std::vector<Sha256Engine> kEngines{
+#ifdef BCX_SHA256_X86
+        {"sha-ni", 1, cpuShaNi, hashShaNi},
+        {"avx2-x8", 4, cpuAvx2, hashAvx2},
+#endif
+        {"scalar", 1, always, hashScalar},
+    };
+  }  // namespace
+
+  const std::vector<Sha256Engine> &sha256Engines() {
+    return kEngines;
+  }
+
+  void sha256(Sha256 *out, const std::string_view *in, size_t n) {
+    static const auto engines = [] {
+      std::vector<Sha256Engine> supported;
+      for (auto &engine : sha256Engines()) {
+        if (engine.supported()) {
+          supported.push_back(engine);
+        }
+      }
+      return supported;
+    }();
+    for (auto &engine : engines) {
+      if (n >= engine.min_batch) {
+        engine.hash(out, in, n);
+        return;
+      }
+    }
+  }
+
+  Sha256 sha256(std::string_view bytes) {
+    Sha256 res;
+    sha256(&res, &bytes, 1);
+    return res;
+  }
+}  // namespace bcx::format
@@ -2,14 +2,15 @@
 
 namespace graphql::bcx {
   template <bool swap, typename C>
-  auto permissionsGranted(size_t i, const C &map) {
+  auto permissionsGranted(const service::SelectionSetParams &params, size_t i, const C &map) {
     std::vector<std::shared_ptr<object::PermissionGranted>> items;
+    std::shared_lock lock{db::account_grant_mutex};
     for (auto &x : boost::make_iterator_range(map.equal_range(i))) {
       auto by = swap ? x.second : x.first;
       auto to = swap ? x.first : x.second;
       for (auto j = 0u; j < x.info.size(); ++j) {
         if (x.info.test(j)) {
-          items.push_back(std::make_shared<PermissionGranted>(Grant{by, to, j}));
+          items.push_back(allocate<PermissionGranted>(params, Grant{by, to, j}));
         }
       }
     }
@@ -21,13 +22,13 @@ namespace graphql::bcx {
   }
 
   FieldResult<IntType> Account::getQuorum(FieldParams&& params) const {
-    return db::account_quorum[i];
+    return db::account_quorum.load(i);
   }
 
   FieldResult<std::vector<std::shared_ptr<object::Role>>> Account::getRoles(FieldParams&& params) const {
     std::vector<std::shared_ptr<object::Role>> items;
     for (auto j : db::account_roles.range(i)) {
-      items.push_back(std::make_shared<Role>(j));
+      items.push_back(allocate<Role>(params, j));
     }
     return items;
   }
@@ -41,25 +42,43 @@ namespace graphql::bcx {
   }
 
   FieldResult<std::vector<std::shared_ptr<object::PermissionGranted>>> Account::getPermissionsGrantedBy(FieldParams&& params) const {
-    return permissionsGranted<false>(i, db::account_grant.left);
+    return permissionsGranted<false>(params, i, db::account_grant.left);
   }
 
   FieldResult<std::vector<std::shared_ptr<object::PermissionGranted>>> Account::getPermissionsGrantedTo(FieldParams&& params) const {
-    return permissionsGranted<true>(i, db::account_grant.right);
+    return permissionsGranted<true>(params, i, db::account_grant.right);
   }
 
   FieldResult<std::shared_ptr<object::Account>> Query::getAccountById(FieldParams&& params, StringType&& idArg) const {
     auto i = db::account_id.find(idArg);
-    return i ? std::make_shared<Account>(*i) : nullptr;
+    return i && *i < counts(params).account ? allocate<Account>(params, *i) : nullptr;
   }
 
-  FieldResult<std::shared_ptr<object::AccountList>> Query::getAccountList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& idArg) const {
-    // TODO: idArg
+  Page accountPage(const db::Counts &counts, std::optional<IntType> after_arg, IntType count, const std::optional<StringType> &id_arg) {
     std::vector<size_t> iv;
-    auto after = afterArg ? *afterArg : -1;
-    for (auto i = after + 1; i >= 0 && i < db::accountCount() && iv.size() < countArg; ++i) {
+    auto after = after_arg ? *after_arg : -1;
+    if (id_arg && !id_arg->empty()) {
+      // substring of id, matches name or domain part
+      std::shared_lock lock{db::account_id_ngrams_mutex};
+      db::account_id_ngrams.candidates(*id_arg, std::max(after + 1, 0), counts.account, [&](size_t i) {
+        if (iv.size() >= count) {
+          return false;
+        }
+        if (db::account_id[i].find(*id_arg) != std::string_view::npos) {
+          iv.push_back(i);
+        }
+        return true;
+      });
+      return {std::move(iv), static_cast<size_t>(after)};
+    }
+    for (auto i = after + 1; i >= 0 && i < counts.account && iv.size() < count; ++i) {
       iv.push_back(i);
     }
-    return AccountList::make(std::move(iv), after);
+    return {std::move(iv), static_cast<size_t>(after)};
+  }
+
+  FieldResult<std::shared_ptr<object::AccountList>> Query::getAccountList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& idArg) const {
+    auto page = accountPage(counts(params), afterArg, countArg, idArg);
+    return AccountList::make(params, std::move(page.items), page.after);
   }
 }  // namespace graphql::bcx
@@ -21,7 +21,7 @@ namespace graphql::bcx {
     std::vector<std::shared_ptr<object::Transaction>> items;
     auto end = db::block_tx_count.offset(i + 1);
     for (auto j = db::block_tx_count.offset(i); j < end; ++j) {
-      items.push_back(std::make_shared<Transaction>(j));
+      items.push_back(allocate<Transaction>(params, j));
     }
     return items;
   }
@@ -31,17 +31,21 @@ namespace graphql::bcx {
   }
 
   FieldResult<std::shared_ptr<object::Block>> Query::getBlockByHeight(FieldParams&& params, IntType&& heightArg) const {
-    return heightArg <= 0 || heightArg > db::blockCount() ? nullptr : std::make_shared<Block>(heightArg - 1);
+    return heightArg <= 0 || heightArg > counts(params).block ? nullptr : allocate<Block>(params, heightArg - 1);
   }
 
-  FieldResult<std::shared_ptr<object::BlockList>> Query::getBlockList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<BooleanType>&& reverseArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg) const {
+  Page blockPage(const db::Counts &counts,
+                 std::optional<IntType> after_arg,
+                 IntType count,
+                 bool reverse,
+                 const std::optional<StringType> &time_after_arg,
+                 const std::optional<StringType> &time_before_arg) {
     std::vector<size_t> iv;
-    auto time_after = timeAfterArg ? format::isoToTime(*timeAfterArg) : std::nullopt;
-    auto time_before = timeBeforeArg ? format::isoToTime(*timeBeforeArg) : std::nullopt;
-    auto blocks_total = static_cast<int>(db::blockCount());
-    auto reverse = reverseArg && *reverseArg;
+    auto time_after = time_after_arg ? format::isoToTime(*time_after_arg) : std::nullopt;
+    auto time_before = time_before_arg ? format::isoToTime(*time_before_arg) : std::nullopt;
+    auto blocks_total = static_cast<int>(counts.block);
     auto step = reverse ? -1 : 1;
-    auto after = afterArg ? *afterArg : reverse ? blocks_total : -1;
+    auto after = after_arg ? *after_arg : reverse ? blocks_total : -1;
     auto i = after + step;
     if (reverse) {
       if (time_before) {
@@ -49,13 +53,18 @@ namespace graphql::bcx {
       }
     } else {
       if (time_after) {
-        i = std::max(i, static_cast<int>(std::lower_bound(db::block_time.begin() + i, db::block_time.end(), *time_after) - db::block_time.begin()));
+        i = std::max(i, static_cast<int>(std::lower_bound(db::block_time.begin() + i, db::block_time.begin() + blocks_total, *time_after) - db::block_time.begin()));
       }
     }
-    while (i >= 0 && i < blocks_total && iv.size() < countArg && (reverse ? !time_after || db::block_time[i] >= *time_after : !time_before || db::block_time[i] < *time_before)) {
+    while (i >= 0 && i < blocks_total && iv.size() < count && (reverse ? !time_after || db::block_time[i] >= *time_after : !time_before || db::block_time[i] < *time_before)) {
       iv.push_back(i);
       i += step;
     }
-    return BlockList::make(std::move(iv), after);
+    return {std::move(iv), static_cast<size_t>(after)};
+  }
+
+  FieldResult<std::shared_ptr<object::BlockList>> Query::getBlockList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<BooleanType>&& reverseArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg) const {
+    auto page = blockPage(counts(params), afterArg, countArg, reverseArg && *reverseArg, timeAfterArg, timeBeforeArg);
+    return BlockList::make(params, std::move(page.items), page.after);
   }
 }  // namespace graphql::bcx
@@ -6,21 +6,21 @@ namespace graphql::bcx {
   }
 
   FieldResult<std::shared_ptr<object::Role>> Domain::getDefaultRole(FieldParams&& params) const {
-    return std::make_shared<Role>(db::domain_role[i]);
+    return allocate<Role>(params, db::domain_role[i]);
   }
 
   FieldResult<std::shared_ptr<object::Domain>> Query::getDomainById(FieldParams&& params, StringType&& idArg) const {
     auto i = db::domain_id.find(idArg);
-    return i ? std::make_shared<Domain>(*i) : nullptr;
+    return i && *i < counts(params).domain ? allocate<Domain>(params, *i) : nullptr;
   }
 
   FieldResult<std::shared_ptr<object::DomainList>> Query::getDomainList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg) const {
     std::vector<size_t> iv;
     auto after = afterArg ? *afterArg : -1;
-    for (auto i = after + 1; i >= 0 && i < db::domainCount() && iv.size() < countArg; ++i) {
+    for (auto i = after + 1; i >= 0 && i < counts(params).domain && iv.size() < countArg; ++i) {
       iv.push_back(i);
     }
-    return DomainList::make(std::move(iv), after);
+    return DomainList::make(params, std::move(iv), after);
   }
 
   FieldResult<StringType> CountPerDomain::getDomain(FieldParams&& params) const {
@@ -28,13 +28,13 @@ namespace graphql::bcx {
   }
 
   FieldResult<IntType> CountPerDomain::getCount(FieldParams&& params) const {
-    return db::domain_tx_count[i];
+    return db::domain_tx_count.load(i);
   }
 
   FieldResult<std::vector<std::shared_ptr<object::CountPerDomain>>> Query::getTransactionCountPerDomain(FieldParams&& params) const {
     std::vector<std::shared_ptr<object::CountPerDomain>> result;
-    for (auto i = 0u; i < db::domainCount(); ++i) {
-      result.push_back(std::make_shared<CountPerDomain>(i));
+    for (auto i = 0u; i < counts(params).domain; ++i) {
+      result.push_back(allocate<CountPerDomain>(params, i));
     }
     return result;
   }
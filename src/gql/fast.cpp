@@ -0,0 +1,778 @@
+#include "gql/fast.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <optional>
+#include <vector>
+
+#include "gql/impl.hpp"
+
+namespace bcx::fast {
+  using graphql::bcx::Page;
+
+  enum class Kind {
+    kTypename,
+    kBlockCount,
+    kTransactionCount,
+    kAccountCount,
+    kPeerCount,
+    kRoleCount,
+    kDomainCount,
+    kBlockByHeight,
+    kBlockList,
+    kTransactionByHash,
+    kTransactionList,
+    kAccountById,
+    kAccountList,
+    kListItems,
+    kListNextAfter,
+    kBlockHeight,
+    kBlockHash,
+    kBlockTransactionCount,
+    kBlockTime,
+    kBlockTransactions,
+    kBlockPreviousHash,
+    kTxHash,
+    kTxCreatedBy,
+    kTxTime,
+    kTxBlockHeight,
+    kTxSignatories,
+    kTxCommandsJson,
+    kAccountId,
+    kAccountQuorum,
+    kAccountRoles,
+    kAccountPermissions,
+    kRoleName,
+    kRolePermissions,
+  };
+
+  // argument is literal or variable
+  struct Input {
+    Literal literal;
+    std::string variable;
+  };
+
+  struct Field {
+    std::string alias;
+    std::string name;
+    std::vector<std::pair<std::string, Input>> arguments;
+    std::vector<Field> selection;
+    Kind kind;
+  };
+
+  struct Operation {
+    std::unordered_map<std::string, std::string> variable_types;
+    std::vector<Field> selection;
+  };
+
+  // subset of schema/gql.gql handled here, other fields fall back to generic resolver
+  struct FieldType {
+    Kind kind;
+    const char *type;
+    std::vector<std::pair<std::string_view, std::string_view>> arguments;
+  };
+  using ObjectType = std::unordered_map<std::string_view, FieldType>;
+
+  const std::unordered_map<std::string_view, ObjectType> &schema() {
+    static const std::unordered_map<std::string_view, ObjectType> schema{
+        {"Query",
+         {
+             {"blockCount", {Kind::kBlockCount, nullptr, {}}},
+             {"transactionCount", {Kind::kTransactionCount, nullptr, {}}},
+             {"accountCount", {Kind::kAccountCount, nullptr, {}}},
+             {"peerCount", {Kind::kPeerCount, nullptr, {}}},
+             {"roleCount", {Kind::kRoleCount, nullptr, {}}},
+             {"domainCount", {Kind::kDomainCount, nullptr, {}}},
+             {"blockByHeight", {Kind::kBlockByHeight, "Block", {{"height", "Int!"}}}},
+             {"blockList",
+              {Kind::kBlockList,
+               "BlockList",
+               {{"after", "Int"}, {"count", "Int!"}, {"reverse", "Boolean"}, {"timeAfter", "String"}, {"timeBefore", "String"}}}},
+             {"transactionByHash", {Kind::kTransactionByHash, "Transaction", {{"hash", "String!"}}}},
+             {"transactionList",
+              {Kind::kTransactionList,
+               "TransactionList",
+               {{"after", "Int"}, {"count", "Int!"}, {"timeAfter", "String"}, {"timeBefore", "String"}, {"creatorId", "String"}, {"reverse", "Boolean"}}}},
+             {"accountById", {Kind::kAccountById, "Account", {{"id", "String!"}}}},
+             {"accountList", {Kind::kAccountList, "AccountList", {{"after", "Int"}, {"count", "Int!"}, {"id", "String"}}}},
+         }},
+        {"BlockList", {{"items", {Kind::kListItems, "Block", {}}}, {"nextAfter", {Kind::kListNextAfter, nullptr, {}}}}},
+        {"TransactionList", {{"items", {Kind::kListItems, "Transaction", {}}}, {"nextAfter", {Kind::kListNextAfter, nullptr, {}}}}},
+        {"AccountList", {{"items", {Kind::kListItems, "Account", {}}}, {"nextAfter", {Kind::kListNextAfter, nullptr, {}}}}},
+        {"Block",
+         {
+             {"height", {Kind::kBlockHeight, nullptr, {}}},
+             {"hash", {Kind::kBlockHash, nullptr, {}}},
+             {"transactionCount", {Kind::kBlockTransactionCount, nullptr, {}}},
+             {"time", {Kind::kBlockTime, nullptr, {}}},
+             {"transactions", {Kind::kBlockTransactions, "Transaction", {}}},
+             {"previousBlockHash", {Kind::kBlockPreviousHash, nullptr, {}}},
+         }},
+        {"Transaction",
+         {
+             {"hash", {Kind::kTxHash, nullptr, {}}},
+             {"createdBy", {Kind::kTxCreatedBy, "Account", {}}},
+             {"time", {Kind::kTxTime, nullptr, {}}},
+             {"blockHeight", {Kind::kTxBlockHeight, nullptr, {}}},
+             {"signatories", {Kind::kTxSignatories, nullptr, {}}},
+             {"commandsJson", {Kind::kTxCommandsJson, nullptr, {}}},
+         }},
+        {"Account",
+         {
+             {"id", {Kind::kAccountId, nullptr, {}}},
+             {"quorum", {Kind::kAccountQuorum, nullptr, {}}},
+             {"roles", {Kind::kAccountRoles, "Role", {}}},
+             {"permissions", {Kind::kAccountPermissions, nullptr, {}}},
+         }},
+        {"Role",
+         {
+             {"name", {Kind::kRoleName, nullptr, {}}},
+             {"permissions", {Kind::kRolePermissions, nullptr, {}}},
+         }},
+    };
+    return schema;
+  }
+
+  auto isNameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  auto isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  class Parser {
+   public:
+    Parser(std::string_view text) : text_{text} {}
+
+    bool operation(Operation &operation) {
+      skip();
+      if (pos_ < text_.size() && isNameStart(text_[pos_])) {
+        std::string keyword;
+        if (!name(keyword) || keyword != "query") {
+          return false;
+        }
+        skip();
+        if (pos_ < text_.size() && isNameStart(text_[pos_])) {
+          std::string operation_name;
+          name(operation_name);
+        }
+        if (accept('(')) {
+          do {
+            std::string variable, type;
+            if (!accept('$') || !name(variable) || !accept(':') || !typeRef(type) || peek('=') || peek('@')) {
+              return false;
+            }
+            if (!operation.variable_types.emplace(std::move(variable), std::move(type)).second) {
+              return false;
+            }
+          } while (!accept(')'));
+        }
+      }
+      if (peek('@') || !selectionSet(operation.selection)) {
+        return false;
+      }
+      skip();
+      return pos_ == text_.size();
+    }
+
+   private:
+    void skip() {
+      while (pos_ < text_.size()) {
+        auto c = text_[pos_];
+        if (c == '#') {
+          while (pos_ < text_.size() && text_[pos_] != '\n' && text_[pos_] != '\r') {
+            ++pos_;
+          }
+        } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',') {
+          ++pos_;
+        } else {
+          break;
+        }
+      }
+    }
+
+    bool peek(char c) {
+      skip();
+      return pos_ < text_.size() && text_[pos_] == c;
+    }
+
+    bool accept(char c) {
+      if (!peek(c)) {
+        return false;
+      }
+      ++pos_;
+      return true;
+    }
+
+    bool name(std::string &out) {
+      skip();
+      if (pos_ >= text_.size() || !isNameStart(text_[pos_])) {
+        return false;
+      }
+      auto begin = pos_;
+      while (pos_ < text_.size() && isNameChar(text_[pos_])) {
+        ++pos_;
+      }
+      out = text_.substr(begin, pos_ - begin);
+      return true;
+    }
+
+    bool typeRef(std::string &out) {
+      if (accept('[')) {
+        std::string item;
+        if (!typeRef(item) || !accept(']')) {
+          return false;
+        }
+        out = "[" + item + "]";
+      } else if (!name(out)) {
+        return false;
+      }
+      if (accept('!')) {
+        out += '!';
+      }
+      return true;
+    }
+
+    bool selectionSet(std::vector<Field> &selection) {
+      if (!accept('{')) {
+        return false;
+      }
+      do {
+        Field field;
+        if (!this->field(field)) {
+          return false;
+        }
+        // generic resolver merges fields with same response key
+        for (auto &other : selection) {
+          if (other.alias == field.alias) {
+            return false;
+          }
+        }
+        selection.push_back(std::move(field));
+      } while (!accept('}'));
+      return true;
+    }
+
+    bool field(Field &field) {
+      if (!name(field.name)) {
+        return false;
+      }
+      if (accept(':')) {
+        field.alias = std::move(field.name);
+        if (!name(field.name)) {
+          return false;
+        }
+      } else {
+        field.alias = field.name;
+      }
+      if (accept('(')) {
+        do {
+          std::string argument;
+          Input input;
+          if (!name(argument) || !accept(':') || !this->input(input)) {
+            return false;
+          }
+          field.arguments.emplace_back(std::move(argument), std::move(input));
+        } while (!accept(')'));
+      }
+      if (peek('@')) {
+        return false;
+      }
+      if (peek('{')) {
+        return selectionSet(field.selection);
+      }
+      return true;
+    }
+
+    // int, string, boolean, null or variable, other values are left to generic parser
+    bool input(Input &input) {
+      if (accept('$')) {
+        return name(input.variable);
+      }
+      skip();
+      if (pos_ >= text_.size()) {
+        return false;
+      }
+      auto c = text_[pos_];
+      if (c == '"') {
+        return string(input.literal);
+      }
+      if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+        auto begin = pos_;
+        if (c == '-') {
+          ++pos_;
+        }
+        while (pos_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[pos_]))) {
+          ++pos_;
+        }
+        if (pos_ < text_.size() && (text_[pos_] == '.' || isNameChar(text_[pos_]))) {
+          return false;
+        }
+        int value;
+        auto [end, error] = std::from_chars(text_.data() + begin, text_.data() + pos_, value);
+        if (error != std::errc{} || end != text_.data() + pos_) {
+          return false;
+        }
+        input.literal = value;
+        return true;
+      }
+      std::string keyword;
+      if (!name(keyword)) {
+        return false;
+      }
+      if (keyword == "true" || keyword == "false") {
+        input.literal = keyword == "true";
+      } else if (keyword != "null") {
+        return false;
+      }
+      return true;
+    }
+
+    bool string(Literal &literal) {
+      if (text_.substr(pos_, 3) == R"(""")") {
+        return false;
+      }
+      std::string value;
+      for (++pos_; pos_ < text_.size(); ++pos_) {
+        auto c = text_[pos_];
+        if (c == '"') {
+          ++pos_;
+          literal = std::move(value);
+          return true;
+        }
+        if (c == '\n' || c == '\r') {
+          return false;
+        }
+        if (c == '\\') {
+          if (++pos_ >= text_.size()) {
+            return false;
+          }
+          switch (text_[pos_]) {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            default: return false;
+          }
+        } else {
+          value += c;
+        }
+      }
+      return false;
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+  };
+
+  bool literalHasType(const Literal &literal, std::string_view type) {
+    if (std::holds_alternative<std::monostate>(literal)) {
+      return type.back() != '!';
+    }
+    if (type.back() == '!') {
+      type.remove_suffix(1);
+    }
+    return type == "Int" ? std::holds_alternative<int>(literal) : type == "Boolean" ? std::holds_alternative<bool>(literal) : std::holds_alternative<std::string>(literal);
+  }
+
+  // static validation against schema, done once per document
+  bool check(const Operation &operation, std::vector<Field> &selection, std::string_view type) {
+    auto &object = schema().at(type);
+    for (auto &field : selection) {
+      if (field.name == "__typename") {
+        field.kind = Kind::kTypename;
+        if (!field.arguments.empty() || !field.selection.empty()) {
+          return false;
+        }
+        continue;
+      }
+      auto it = object.find(field.name);
+      if (it == object.end()) {
+        return false;
+      }
+      auto &field_type = it->second;
+      field.kind = field_type.kind;
+      for (size_t i = 0; i < field.arguments.size(); ++i) {
+        auto &[name, input] = field.arguments[i];
+        for (size_t j = 0; j < i; ++j) {
+          if (field.arguments[j].first == name) {
+            return false;
+          }
+        }
+        auto argument = std::find_if(field_type.arguments.begin(), field_type.arguments.end(), [&](auto &x) { return x.first == name; });
+        if (argument == field_type.arguments.end()) {
+          return false;
+        }
+        if (input.variable.empty()) {
+          if (!literalHasType(input.literal, argument->second)) {
+            return false;
+          }
+        } else {
+          auto variable = operation.variable_types.find(input.variable);
+          if (variable == operation.variable_types.end()) {
+            return false;
+          }
+          auto &variable_type = variable->second;
+          if (variable_type != argument->second && variable_type != std::string{argument->second} + "!") {
+            return false;
+          }
+        }
+      }
+      for (auto &[name, argument_type] : field_type.arguments) {
+        if (argument_type.back() == '!' && std::none_of(field.arguments.begin(), field.arguments.end(), [&](auto &x) { return x.first == name; })) {
+          return false;
+        }
+      }
+      if (field_type.type == nullptr ? !field.selection.empty() : field.selection.empty() || !check(operation, field.selection, field_type.type)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::shared_ptr<const Operation> parse(std::string_view text) {
+    auto operation = std::make_shared<Operation>();
+    if (!Parser{text}.operation(*operation) || !check(*operation, operation->selection, "Query")) {
+      return nullptr;
+    }
+    return operation;
+  }
+
+  class Writer {
+   public:
+    Writer(std::string &out, const Variables &variables, const db::Counts &counts) : out_{out}, variables_{variables}, counts_{counts} {}
+
+    bool query(const Operation &operation) {
+      out_ += R"({"data":{)";
+      for (auto &field : operation.selection) {
+        key(field, &field == &operation.selection.front());
+        if (!queryField(field)) {
+          return false;
+        }
+      }
+      out_ += "}}";
+      return true;
+    }
+
+   private:
+    // argument value after variable substitution, false if generic resolver must report error
+    template <typename T>
+    bool argument(const Field &field, std::string_view name, std::optional<T> &out) {
+      out.reset();
+      for (auto &[argument, input] : field.arguments) {
+        if (argument != name) {
+          continue;
+        }
+        auto literal = &input.literal;
+        if (!input.variable.empty()) {
+          auto it = variables_.find(input.variable);
+          if (it == variables_.end()) {
+            return false;
+          }
+          literal = &it->second;
+        }
+        if (std::holds_alternative<std::monostate>(*literal)) {
+          return true;
+        }
+        if (!std::holds_alternative<T>(*literal)) {
+          return false;
+        }
+        out = std::get<T>(*literal);
+        return true;
+      }
+      return true;
+    }
+
+    template <typename T>
+    bool required(const Field &field, std::string_view name, std::optional<T> &out) {
+      return argument(field, name, out) && out;
+    }
+
+    bool queryField(const Field &field) {
+      switch (field.kind) {
+        case Kind::kTypename: string("Query"); return true;
+        case Kind::kBlockCount: integer(counts_.block); return true;
+        case Kind::kTransactionCount: integer(counts_.tx); return true;
+        case Kind::kAccountCount: integer(counts_.account); return true;
+        case Kind::kPeerCount: integer(counts_.peer); return true;
+        case Kind::kRoleCount: integer(counts_.role); return true;
+        case Kind::kDomainCount: integer(counts_.domain); return true;
+        case Kind::kBlockByHeight: {
+          std::optional<int> height;
+          if (!required(field, "height", height)) {
+            return false;
+          }
+          if (*height <= 0 || *height > counts_.block) {
+            out_ += "null";
+          } else {
+            block(field.selection, *height - 1);
+          }
+          return true;
+        }
+        case Kind::kBlockList: {
+          std::optional<int> after, count;
+          std::optional<bool> reverse;
+          std::optional<std::string> time_after, time_before;
+          if (!argument(field, "after", after) || !required(field, "count", count) || !argument(field, "reverse", reverse) || !argument(field, "timeAfter", time_after) || !argument(field, "timeBefore", time_before)) {
+            return false;
+          }
+          list(field.selection, "BlockList", graphql::bcx::blockPage(counts_, after, *count, reverse && *reverse, time_after, time_before), &Writer::block);
+          return true;
+        }
+        case Kind::kTransactionByHash: {
+          std::optional<std::string> hash_arg;
+          if (!required(field, "hash", hash_arg)) {
+            return false;
+          }
+          std::optional<size_t> i;
+          if (auto hash = format::unhex<Sha256>(*hash_arg)) {
+            i = db::tx_hash.find(*hash);
+          }
+          if (i && *i < counts_.tx) {
+            transaction(field.selection, *i);
+          } else {
+            out_ += "null";
+          }
+          return true;
+        }
+        case Kind::kTransactionList: {
+          std::optional<int> after, count;
+          std::optional<bool> reverse;
+          std::optional<std::string> time_after, time_before, creator_id;
+          if (!argument(field, "after", after) || !required(field, "count", count) || !argument(field, "timeAfter", time_after) || !argument(field, "timeBefore", time_before) || !argument(field, "creatorId", creator_id) || !argument(field, "reverse", reverse)) {
+            return false;
+          }
+          list(field.selection, "TransactionList", graphql::bcx::transactionPage(counts_, after, *count, time_after, time_before, creator_id, reverse && *reverse), &Writer::transaction);
+          return true;
+        }
+        case Kind::kAccountById: {
+          std::optional<std::string> id;
+          if (!required(field, "id", id)) {
+            return false;
+          }
+          auto i = db::account_id.find(*id);
+          if (i && *i < counts_.account) {
+            account(field.selection, *i);
+          } else {
+            out_ += "null";
+          }
+          return true;
+        }
+        case Kind::kAccountList: {
+          std::optional<int> after, count;
+          std::optional<std::string> id;
+          if (!argument(field, "after", after) || !required(field, "count", count) || !argument(field, "id", id)) {
+            return false;
+          }
+          list(field.selection, "AccountList", graphql::bcx::accountPage(counts_, after, *count, id), &Writer::account);
+          return true;
+        }
+        default: return false;
+      }
+    }
+
+    void list(const std::vector<Field> &selection, const char *type, const Page &page, void (Writer::*item)(const std::vector<Field> &, size_t)) {
+      out_ += '{';
+      for (auto &field : selection) {
+        key(field, &field == &selection.front());
+        switch (field.kind) {
+          case Kind::kTypename: string(type); break;
+          case Kind::kListItems: {
+            out_ += '[';
+            for (auto &i : page.items) {
+              if (&i != &page.items.front()) {
+                out_ += ',';
+              }
+              (this->*item)(field.selection, i);
+            }
+            out_ += ']';
+            break;
+          }
+          case Kind::kListNextAfter: integer(page.items.empty() ? page.after : page.items.back()); break;
+          default: break;
+        }
+      }
+      out_ += '}';
+    }
+
+    void block(const std::vector<Field> &selection, size_t i) {
+      out_ += '{';
+      for (auto &field : selection) {
+        key(field, &field == &selection.front());
+        switch (field.kind) {
+          case Kind::kTypename: string("Block"); break;
+          case Kind::kBlockHeight: integer(i + 1); break;
+          case Kind::kBlockHash: string(format::hex(db::block_hash[i])); break;
+          case Kind::kBlockTransactionCount: integer(db::block_tx_count.size(i)); break;
+          case Kind::kBlockTime: string(format::timeToIso(db::block_time[i])); break;
+          case Kind::kBlockTransactions: {
+            out_ += '[';
+            auto begin = db::block_tx_count.offset(i), end = db::block_tx_count.offset(i + 1);
+            for (auto j = begin; j < end; ++j) {
+              if (j != begin) {
+                out_ += ',';
+              }
+              transaction(field.selection, j);
+            }
+            out_ += ']';
+            break;
+          }
+          case Kind::kBlockPreviousHash: string(i == 0 ? "-" : format::hex(db::block_hash[i - 1])); break;
+          default: break;
+        }
+      }
+      out_ += '}';
+    }
+
+    void transaction(const std::vector<Field> &selection, size_t i) {
+      out_ += '{';
+      for (auto &field : selection) {
+        key(field, &field == &selection.front());
+        switch (field.kind) {
+          case Kind::kTypename: string("Transaction"); break;
+          case Kind::kTxHash: string(format::hex(db::tx_hash[i])); break;
+          case Kind::kTxCreatedBy: account(field.selection, db::tx_creator[i]); break;
+          case Kind::kTxTime: string(format::timeToIso(db::tx_time[i])); break;
+          case Kind::kTxBlockHeight: integer(db::block_tx_count.index(i) + 1); break;
+          case Kind::kTxSignatories: {
+            out_ += '[';
+            auto first = true;
+            for (auto j : db::tx_pubs.range(i)) {
+              if (!first) {
+                out_ += ',';
+              }
+              first = false;
+              string(format::hex(db::all_pub[j]));
+            }
+            out_ += ']';
+            break;
+          }
+          case Kind::kTxCommandsJson: {
+            auto cmd = db::tx_cmds[i];
+            auto bytes = db::block_bytes.get(db::block_tx_count.index(i));
+            string(format::txCmdJson({bytes.view.data() + cmd.first, cmd.second}));
+            break;
+          }
+          default: break;
+        }
+      }
+      out_ += '}';
+    }
+
+    void account(const std::vector<Field> &selection, size_t i) {
+      out_ += '{';
+      for (auto &field : selection) {
+        key(field, &field == &selection.front());
+        switch (field.kind) {
+          case Kind::kTypename: string("Account"); break;
+          case Kind::kAccountId: string(db::account_id[i]); break;
+          case Kind::kAccountQuorum: integer(db::account_quorum.load(i)); break;
+          case Kind::kAccountRoles: {
+            out_ += '[';
+            auto first = true;
+            for (auto j : db::account_roles.range(i)) {
+              if (!first) {
+                out_ += ',';
+              }
+              first = false;
+              role(field.selection, j);
+            }
+            out_ += ']';
+            break;
+          }
+          case Kind::kAccountPermissions: {
+            RolePerms perms;
+            for (auto j : db::account_roles.range(i)) {
+              perms |= db::role_perms[j];
+            }
+            strings(format::rolePermNames(perms));
+            break;
+          }
+          default: break;
+        }
+      }
+      out_ += '}';
+    }
+
+    void role(const std::vector<Field> &selection, size_t i) {
+      out_ += '{';
+      for (auto &field : selection) {
+        key(field, &field == &selection.front());
+        switch (field.kind) {
+          case Kind::kTypename: string("Role"); break;
+          case Kind::kRoleName: string(db::role_name[i]); break;
+          case Kind::kRolePermissions: strings(format::rolePermNames(db::role_perms[i])); break;
+          default: break;
+        }
+      }
+      out_ += '}';
+    }
+
+    void key(const Field &field, bool first) {
+      if (!first) {
+        out_ += ',';
+      }
+      string(field.alias);
+      out_ += ':';
+    }
+
+    // same truncation to int as generic resolver
+    void integer(size_t value) {
+      char buffer[16];
+      auto end = std::to_chars(std::begin(buffer), std::end(buffer), static_cast<int>(value)).ptr;
+      out_.append(buffer, end);
+    }
+
+    // same escaping as rapidjson::Writer used by generic resolver
+    void string(std::string_view value) {
+      static const char kHex[] = "0123456789ABCDEF";
+      out_ += '"';
+      for (auto c : value) {
+        auto u = static_cast<unsigned char>(c);
+        switch (c) {
+          case '"': out_ += "\\\""; break;
+          case '\\': out_ += "\\\\"; break;
+          case '\b': out_ += "\\b"; break;
+          case '\f': out_ += "\\f"; break;
+          case '\n': out_ += "\\n"; break;
+          case '\r': out_ += "\\r"; break;
+          case '\t': out_ += "\\t"; break;
+          default:
+            if (u < 0x20) {
+              out_ += "\\u00";
+              out_ += kHex[u >> 4];
+              out_ += kHex[u & 0xF];
+            } else {
+              out_ += c;
+            }
+        }
+      }
+      out_ += '"';
+    }
+
+    void strings(const std::vector<std::string> &values) {
+      out_ += '[';
+      for (auto &value : values) {
+        if (&value != &values.front()) {
+          out_ += ',';
+        }
+        string(value);
+      }
+      out_ += ']';
+    }
+
+    std::string &out_;
+    const Variables &variables_;
+    const db::Counts &counts_;
+  };
+
+  bool write(std::string &out, const Operation &operation, const Variables &variables, const db::Counts &counts) {
+    return Writer{out, variables, counts}.query(operation);
+  }
+}  // namespace bcx::fast
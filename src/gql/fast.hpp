@@ -0,0 +1,27 @@
+#ifndef BCX_GQL_FAST_HPP
+#define BCX_GQL_FAST_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+
+#include "db/db.hpp"
+
+// serializes common queries straight to json, without response::Value tree
+namespace bcx::fast {
+  // variable value, monostate is null or unsupported json type
+  using Literal = std::variant<std::monostate, int, bool, std::string>;
+  using Variables = std::unordered_map<std::string, Literal>;
+
+  struct Operation;
+
+  // nullptr if query is not supported (fragments, directives, other fields) or invalid
+  std::shared_ptr<const Operation> parse(std::string_view text);
+
+  // appends `{"data":...}` identical to generic resolver, false if generic resolver must handle request
+  bool write(std::string &out, const Operation &operation, const Variables &variables, const db::Counts &counts);
+}  // namespace bcx::fast
+
+#endif  // BCX_GQL_FAST_HPP
@@ -7,6 +7,38 @@
 
 namespace graphql::bcx {
   using namespace ::bcx;
+
+  // counts published when request started, resolvers don't look past them
+  struct State : Arena {
+    inline State(db::Counts counts) : counts{counts} {}
+
+    db::Counts counts;
+  };
+
+  inline const db::Counts &counts(const service::SelectionSetParams &params) {
+    return static_cast<const State &>(*params.state).counts;
+  }
+
+  // items of paginated list and `after` they follow, shared by resolvers and fast path
+  struct Page {
+    std::vector<size_t> items;
+    size_t after;
+  };
+
+  Page blockPage(const db::Counts &counts,
+                 std::optional<IntType> after_arg,
+                 IntType count,
+                 bool reverse,
+                 const std::optional<StringType> &time_after_arg,
+                 const std::optional<StringType> &time_before_arg);
+  Page transactionPage(const db::Counts &counts,
+                       std::optional<IntType> after_arg,
+                       IntType count,
+                       const std::optional<StringType> &time_after_arg,
+                       const std::optional<StringType> &time_before_arg,
+                       const std::optional<StringType> &creator_id_arg,
+                       bool reverse);
+  Page accountPage(const db::Counts &counts, std::optional<IntType> after_arg, IntType count, const std::optional<StringType> &id_arg);
 }  // namespace graphql::bcx
 
 #endif  // BCX_GQL_IMPL_HPP
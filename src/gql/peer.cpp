@@ -15,15 +15,15 @@ namespace graphql::bcx {
       return nullptr;
     }
     auto i = db::peer_pub.find(*pub);
-    return i ? std::make_shared<Peer>(*i) : nullptr;
+    return i && *i < counts(params).peer ? allocate<Peer>(params, *i) : nullptr;
   }
 
   FieldResult<std::shared_ptr<object::PeerList>> Query::getPeerList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg) const {
     std::vector<size_t> iv;
     auto after = afterArg ? *afterArg : -1;
-    for (auto i = after + 1; i >= 0 && i < db::peerCount() && iv.size() < countArg; ++i) {
+    for (auto i = after + 1; i >= 0 && i < counts(params).peer && iv.size() < countArg; ++i) {
       iv.push_back(i);
     }
-    return PeerList::make(std::move(iv), after);
+    return PeerList::make(params, std::move(iv), after);
   }
 }  // namespace graphql::bcx
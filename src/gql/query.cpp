@@ -1,83 +1,125 @@
 #include "gql/impl.hpp"
 
-std::chrono::milliseconds truncNow(std::chrono::seconds step) {
+constexpr int64_t kMinute = 60000;
+constexpr int64_t kMaxBuckets = 100000;
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t localOffsetMs() {
   auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-  auto tm = *localtime(&time);
-  if (step == std::chrono::minutes(1)) {
-    tm.tm_sec = 0;
-  } else if (step == std::chrono::hours(1)) {
-    tm.tm_sec = 0;
-    tm.tm_min = 0;
-  }
-  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::from_time_t(mktime(&tm)).time_since_epoch());
+  tm tm;
+  localtime_r(&time, &tm);
+  return tm.tm_gmtoff * int64_t{1000};
 }
 
-std::vector<int> countPerTime(const std::vector<uint64_t> times, std::chrono::seconds step, size_t steps) {
-  std::vector<int> buckets(steps, 0);
-  auto cut = truncNow(step);
-  auto bucket = buckets.rbegin();
-  auto time = times.rbegin();
-  auto stop = false;
-  while (true) {
-    while (true) {
-      stop = time == times.rend() || bucket == buckets.rend();
-      if (stop) {
-        break;
-      }
-      if (*time >= cut.count()) {
-        break;
-      } else {
-        ++bucket;
-        cut -= step;
-      }
-    }
-    if (stop) {
-      break;
-    }
-    ++(*bucket);
-    ++time;
-  }
-  return buckets;
+// reported in response errors
+void invalidArgument(const std::string &message) {
+  throw graphql::service::schema_exception(std::vector<std::string>{message});
+}
+
+// `count` buckets of `step` ending with current one, aligned to time zone offset
+std::vector<int> countPerTime(const bcx::ds::Rollup &rollup, int64_t step, int64_t offset, int count) {
+  if (count <= 0) {
+    return {};
+  }
+  if (count > kMaxBuckets) {
+    invalidArgument(fmt::format("count must be at most {}", kMaxBuckets));
+  }
+  auto now = nowMs();
+  auto begin = (now + offset) / step * step - offset - static_cast<int64_t>(count - 1) * step;
+  if (begin < 0) {
+    return {};
+  }
+  auto buckets = rollup.buckets(begin, step, count);
+  return {buckets.begin(), buckets.end()};
+}
+
+std::vector<int> countPerTime(const bcx::ds::Rollup &rollup,
+                              const std::string &from_arg,
+                              const std::optional<std::string> &to_arg,
+                              int step_arg,
+                              const std::optional<int> &utc_offset_arg) {
+  auto from = bcx::format::isoToTime(from_arg);
+  if (!from) {
+    invalidArgument("from must be ISO 8601 time");
+  }
+  auto to = to_arg ? bcx::format::isoToTime(*to_arg) : std::optional<uint64_t>{nowMs()};
+  if (!to) {
+    invalidArgument("to must be ISO 8601 time");
+  }
+  if (*to <= *from) {
+    invalidArgument("to must be after from");
+  }
+  if (step_arg <= 0 || step_arg % 60 != 0) {
+    invalidArgument("step must be positive multiple of 60 seconds");
+  }
+  auto step = step_arg * int64_t{1000};
+  auto offset = utc_offset_arg.value_or(0) * kMinute;
+  auto begin = static_cast<int64_t>(*from) + offset;
+  begin = begin - (begin % step + step) % step - offset;
+  if (begin < 0) {
+    invalidArgument("from must be after 1970");
+  }
+  auto count = (static_cast<int64_t>(*to) - begin + step - 1) / step;
+  if (count > kMaxBuckets) {
+    invalidArgument(fmt::format("from and to span {} steps, at most {} are allowed", count, kMaxBuckets));
+  }
+  auto buckets = rollup.buckets(begin, step, count);
+  return {buckets.begin(), buckets.end()};
 }
 
 namespace graphql::bcx {
   FieldResult<IntType> Query::getBlockCount(FieldParams&& params) const {
-    return db::blockCount();
+    return counts(params).block;
   }
 
   FieldResult<IntType> Query::getTransactionCount(FieldParams&& params) const {
-    return db::txCount();
+    return counts(params).tx;
   }
 
   FieldResult<IntType> Query::getAccountCount(FieldParams&& params) const {
-    return db::accountCount();
+    return counts(params).account;
   }
 
   FieldResult<IntType> Query::getPeerCount(FieldParams&& params) const {
-    return db::peerCount();
+    return counts(params).peer;
   }
 
   FieldResult<IntType> Query::getRoleCount(FieldParams&& params) const {
-    return db::roleCount();
+    return counts(params).role;
   }
 
   FieldResult<IntType> Query::getDomainCount(FieldParams&& params) const {
-    return db::domainCount();
+    return counts(params).domain;
   }
 
   FieldResult<std::vector<IntType>> Query::getTransactionCountPerMinute(FieldParams&& params, IntType&& countArg) const {
-    return countPerTime(db::tx_time, std::chrono::minutes(1), countArg);
+    return countPerTime(db::tx_rollup, kMinute, localOffsetMs(), countArg);
   }
 
   FieldResult<std::vector<IntType>> Query::getTransactionCountPerHour(FieldParams&& params, IntType&& countArg) const {
-    return countPerTime(db::tx_time, std::chrono::hours(1), countArg);
+    return countPerTime(db::tx_rollup, 60 * kMinute, localOffsetMs(), countArg);
   }
 
   FieldResult<std::vector<IntType>> Query::getBlockCountPerMinute(FieldParams&& params, IntType&& countArg) const {
-    return countPerTime(db::block_time, std::chrono::minutes(1), countArg);
+    return countPerTime(db::block_rollup, kMinute, localOffsetMs(), countArg);
   }
 
   FieldResult<std::vector<IntType>> Query::getBlockCountPerHour(FieldParams&& params, IntType&& countArg) const {
-    return countPerTime(db::block_time, std::chrono::hours(1), countArg);
+    return countPerTime(db::block_rollup, 60 * kMinute, localOffsetMs(), countArg);
+  }
+
+  FieldResult<std::vector<IntType>> Query::getBlockCountPerTime(FieldParams&& params, StringType&& fromArg, std::optional<StringType>&& toArg, IntType&& stepArg, std::optional<IntType>&& utcOffsetArg) const {
+    return countPerTime(db::block_rollup, fromArg, toArg, stepArg, utcOffsetArg);
+  }
+
+  FieldResult<std::vector<IntType>> Query::getTransactionCountPerTime(FieldParams&& params, StringType&& fromArg, std::optional<StringType>&& toArg, IntType&& stepArg, std::optional<IntType>&& utcOffsetArg) const {
+    return countPerTime(db::tx_rollup, fromArg, toArg, stepArg, utcOffsetArg);
+  }
+
+  FieldResult<std::vector<IntType>> Query::getCommandCountPerTime(FieldParams&& params, StringType&& fromArg, std::optional<StringType>&& toArg, IntType&& stepArg, std::optional<IntType>&& utcOffsetArg) const {
+    return countPerTime(db::command_rollup, fromArg, toArg, stepArg, utcOffsetArg);
   }
 }  // namespace graphql::bcx
@@ -23,15 +23,15 @@ namespace graphql::bcx {
 
   FieldResult<std::shared_ptr<object::Role>> Query::getRoleByName(FieldParams&& params, StringType&& nameArg) const {
     auto i = db::role_name.find(nameArg);
-    return i ? std::make_shared<Role>(*i) : nullptr;
+    return i && *i < counts(params).role ? allocate<Role>(params, *i) : nullptr;
   }
 
   FieldResult<std::shared_ptr<object::RoleList>> Query::getRoleList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg) const {
     std::vector<size_t> iv;
     auto after = afterArg ? *afterArg : -1;
-    for (auto i = after + 1; i >= 0 && i < db::roleCount() && iv.size() < countArg; ++i) {
+    for (auto i = after + 1; i >= 0 && i < counts(params).role && iv.size() < countArg; ++i) {
       iv.push_back(i);
     }
-    return RoleList::make(std::move(iv), after);
+    return RoleList::make(params, std::move(iv), after);
   }
 }  // namespace graphql::bcx
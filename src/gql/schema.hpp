@@ -1,6 +1,7 @@
 #ifndef BCX_GQL_SCHEMA_HPP
 #define BCX_GQL_SCHEMA_HPP
 
+#include <memory_resource>
 #include <string>
 
 #include "gen/gql/BcxSchema.h"
@@ -17,6 +18,18 @@ namespace graphql::bcx {
   using response::StringType;
   using response::BooleanType;
 
+  // resolver objects of request are allocated from its state and released together,
+  // requests resolve with deferred launch so arena is used from one thread
+  struct Arena : service::RequestState {
+    std::pmr::monotonic_buffer_resource resource;
+  };
+
+  template <typename T, typename... A>
+  std::shared_ptr<T> allocate(const service::SelectionSetParams &params, A &&...args) {
+    auto &arena = static_cast<Arena &>(*params.state);
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>{&arena.resource}, std::forward<A>(args)...);
+  }
+
   template <typename ListBase, typename ItemBase, typename Item>
   struct List : ListBase {
     static_assert(std::is_base_of_v<ItemBase, Item>);
@@ -25,8 +38,9 @@ namespace graphql::bcx {
 
     FieldResult<std::vector<std::shared_ptr<ItemBase>>> getItems(FieldParams&& params) const override {
       std::vector<std::shared_ptr<ItemBase>> items;
+      items.reserve(iv.size());
       for (auto i : iv) {
-        items.push_back(std::make_shared<Item>(i));
+        items.push_back(allocate<Item>(params, i));
       }
       return items;
     }
@@ -35,11 +49,11 @@ namespace graphql::bcx {
       return after;
     }
 
-    static auto make(std::vector<size_t> &&iv, size_t after) {
+    static auto make(const service::SelectionSetParams &params, std::vector<size_t> &&iv, size_t after) {
       if (!iv.empty()) {
         after = iv.back();
       }
-      return std::make_shared<List>(std::move(iv), after);
+      return allocate<List>(params, std::move(iv), after);
     }
 
     std::vector<size_t> iv;
@@ -164,7 +178,7 @@ namespace graphql::bcx {
     FieldResult<std::shared_ptr<object::Role>> getRoleByName(FieldParams&& params, StringType&& nameArg) const override;
     FieldResult<std::shared_ptr<object::Domain>> getDomainById(FieldParams&& params, StringType&& idArg) const override;
     FieldResult<std::shared_ptr<object::BlockList>> getBlockList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<BooleanType>&& reverseArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg) const override;
-    FieldResult<std::shared_ptr<object::TransactionList>> getTransactionList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg, std::optional<StringType>&& creatorIdArg) const override;
+    FieldResult<std::shared_ptr<object::TransactionList>> getTransactionList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg, std::optional<StringType>&& creatorIdArg, std::optional<BooleanType>&& reverseArg) const override;
     FieldResult<std::shared_ptr<object::AccountList>> getAccountList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& idArg) const override;
     FieldResult<std::shared_ptr<object::PeerList>> getPeerList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg) const override;
     FieldResult<std::shared_ptr<object::RoleList>> getRoleList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg) const override;
@@ -173,6 +187,9 @@ namespace graphql::bcx {
     FieldResult<std::vector<IntType>> getTransactionCountPerHour(FieldParams&& params, IntType&& countArg) const override;
     FieldResult<std::vector<IntType>> getBlockCountPerMinute(FieldParams&& params, IntType&& countArg) const override;
     FieldResult<std::vector<IntType>> getBlockCountPerHour(FieldParams&& params, IntType&& countArg) const override;
+    FieldResult<std::vector<IntType>> getBlockCountPerTime(FieldParams&& params, StringType&& fromArg, std::optional<StringType>&& toArg, IntType&& stepArg, std::optional<IntType>&& utcOffsetArg) const override;
+    FieldResult<std::vector<IntType>> getTransactionCountPerTime(FieldParams&& params, StringType&& fromArg, std::optional<StringType>&& toArg, IntType&& stepArg, std::optional<IntType>&& utcOffsetArg) const override;
+    FieldResult<std::vector<IntType>> getCommandCountPerTime(FieldParams&& params, StringType&& fromArg, std::optional<StringType>&& toArg, IntType&& stepArg, std::optional<IntType>&& utcOffsetArg) const override;
     FieldResult<std::vector<std::shared_ptr<object::CountPerDomain>>> getTransactionCountPerDomain(FieldParams&& params) const override;
   };
 }  // namespace graphql::bcx
@@ -1,36 +1,237 @@
 #include <graphqlservice/JSONResponse.h>
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <atomic>
+#include <cctype>
+#include <mutex>
+#include <shared_mutex>
 
-#include "gql/schema.hpp"
+#include "gql/fast.hpp"
+#include "gql/impl.hpp"
 #include "gql/service.hpp"
 
 namespace bcx {
   static auto service = std::make_shared<graphql::service::Request>(graphql::service::TypeMap{{"query", std::make_shared<graphql::bcx::Query>()}});
 
+  auto isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  // drops insignificant whitespace, commas and comments outside of strings
+  std::string normalizeQuery(std::string_view query) {
+    std::string result;
+    auto space = false;
+    for (size_t i = 0; i < query.size(); ++i) {
+      auto c = query[i];
+      if (c == '#') {
+        while (i < query.size() && query[i] != '\n') {
+          ++i;
+        }
+        space = true;
+      } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',') {
+        space = true;
+      } else {
+        if (space && !result.empty() && isNameChar(result.back()) && isNameChar(c)) {
+          result += ' ';
+        }
+        space = false;
+        result += c;
+        if (c == '"') {
+          for (++i; i < query.size() && query[i] != '"'; ++i) {
+            if (query[i] == '\\' && i + 1 < query.size()) {
+              result += query[i++];
+            }
+            result += query[i];
+          }
+          if (i < query.size()) {
+            result += '"';
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  struct Document {
+    std::string text;
+    std::string normalized;
+    graphql::peg::ast ast;
+    std::shared_ptr<const fast::Operation> fast;
+  };
+
+  // parsed queries by sha256 of text, clients may send only hash of cached query
+  namespace documents {
+    static std::mutex mutex;
+
+    auto &lru() {
+      static ds::Lru<Sha256, std::shared_ptr<const Document>> lru{config.gql_document_cache};
+      return lru;
+    }
+
+    std::shared_ptr<const Document> get(const Sha256 &hash) {
+      std::lock_guard lock{mutex};
+      auto document = lru().get(hash);
+      return document ? *document : nullptr;
+    }
+
+    std::shared_ptr<const Document> parse(const Sha256 &hash, std::string_view text) {
+      auto document = std::make_shared<Document>();
+      document->text = text;
+      document->normalized = normalizeQuery(text);
+      document->ast = graphql::peg::parseString(document->text);
+      if (config.gql_fast) {
+        document->fast = fast::parse(document->text);
+      }
+      std::lock_guard lock{mutex};
+      lru().put(hash, document, 1);
+      return document;
+    }
+  }  // namespace documents
+
+  // responses for current height and minute (time buckets depend on it)
+  namespace responses {
+    static std::mutex mutex;
+    static size_t height, minute, rollbacks;
+    static std::atomic_size_t hits, misses;
+
+    auto &lru() {
+      static ds::Lru<std::string, std::string> lru{config.gql_cache_bytes};
+      return lru;
+    }
+
+    size_t currentMinute() {
+      return std::chrono::duration_cast<std::chrono::minutes>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // must be called with mutex and db::rollback_mutex locked, false for requests older than cached height
+    bool refresh(size_t block_count) {
+      auto now = currentMinute();
+      auto rollback_count = db::rollbackCount();
+      if (block_count > height || (block_count == height && now != minute) || rollback_count != rollbacks) {
+        lru().clear();
+        height = block_count;
+        minute = now;
+        rollbacks = rollback_count;
+      }
+      return block_count == height;
+    }
+
+    std::optional<std::string> get(const std::string &key, size_t block_count) {
+      std::lock_guard lock{mutex};
+      auto response = refresh(block_count) ? lru().get(key) : nullptr;
+      if (response == nullptr) {
+        ++misses;
+        return std::nullopt;
+      }
+      ++hits;
+      return *response;
+    }
+
+    void put(const std::string &key, const std::string &response, size_t block_count) {
+      std::lock_guard lock{mutex};
+      if (refresh(block_count)) {
+        lru().put(key, response, 2 * key.size() + response.size());
+      }
+    }
+  }  // namespace responses
+
   std::string gql(const std::string &body) {
     using graphql::response::Value;
     rapidjson::Document jdoc;
     jdoc.Parse(body);
     auto jbody = jdoc.GetObject();
     Value vars{graphql::response::Type::Map};
+    fast::Variables fast_vars;
+    rapidjson::StringBuffer jvars_text;
     if (jbody.HasMember("variables")) {
       auto &jvars = jbody["variables"];
       if (jvars.IsObject()) {
+        rapidjson::Writer<rapidjson::StringBuffer> writer{jvars_text};
+        jvars.Accept(writer);
         for (auto &pair : jvars.GetObject()) {
           auto &jval = pair.value;
           Value val;
+          fast::Literal literal;
           if (jval.IsString()) {
             val = Value(jval.GetString());
+            literal = std::string{jval.GetString(), jval.GetStringLength()};
           } else if (jval.IsInt()) {
             val = Value(jval.GetInt());
+            literal = jval.GetInt();
           } else if (jval.IsBool()) {
             val = Value(jval.GetBool());
+            literal = jval.GetBool();
           }
+          fast_vars.emplace(pair.name.GetString(), std::move(literal));
           vars.emplace_back(pair.name.GetString(), std::move(val));
         }
       }
     }
-    auto query = graphql::peg::parseString(jbody["query"].GetString());
-    return graphql::response::toJSON(service->resolve(nullptr, *query.root, "", std::move(vars)).get());
+    std::optional<Sha256> persisted;
+    if (jbody.HasMember("extensions") && jbody["extensions"].IsObject()) {
+      auto jext = jbody["extensions"].GetObject();
+      if (jext.HasMember("persistedQuery") && jext["persistedQuery"].IsObject()) {
+        auto jpersisted = jext["persistedQuery"].GetObject();
+        if (jpersisted.HasMember("sha256Hash") && jpersisted["sha256Hash"].IsString()) {
+          persisted = format::unhex<Sha256>(jpersisted["sha256Hash"].GetString());
+        }
+        if (!persisted) {
+          return R"({"errors":[{"message":"Invalid persisted query hash"}]})";
+        }
+      }
+    }
+    std::shared_ptr<const Document> document;
+    if (jbody.HasMember("query") && jbody["query"].IsString()) {
+      std::string_view text{jbody["query"].GetString(), jbody["query"].GetStringLength()};
+      auto hash = format::sha256(text);
+      if (persisted && *persisted != hash) {
+        return R"({"errors":[{"message":"provided sha does not match query"}]})";
+      }
+      document = documents::get(hash);
+      if (!document) {
+        document = documents::parse(hash, text);
+      }
+    } else if (persisted) {
+      document = documents::get(*persisted);
+      if (!document) {
+        return R"({"errors":[{"message":"PersistedQueryNotFound","extensions":{"code":"PERSISTED_QUERY_NOT_FOUND"}}]})";
+      }
+    } else {
+      return R"({"errors":[{"message":"Must provide query string"}]})";
+    }
+    std::shared_lock rollback_lock{db::rollback_mutex};
+    auto counts = db::counts();
+    std::string key;
+    if (config.gql_cache_bytes != 0) {
+      key = document->normalized;
+      key += '\n';
+      key += jvars_text.GetString();
+      if (auto response = responses::get(key, counts.block)) {
+        return std::move(*response);
+      }
+    }
+    // reused buffer, generic resolver only for queries fast path can't serialize
+    thread_local std::string fast_response;
+    fast_response.clear();
+    std::string response;
+    if (document->fast && fast::write(fast_response, *document->fast, fast_vars, counts)) {
+      response = fast_response;
+    } else {
+      auto state = std::make_shared<graphql::bcx::State>(counts);
+      response = graphql::response::toJSON(service->resolve(state, *document->ast.root, "", std::move(vars)).get());
+    }
+    if (config.gql_cache_bytes != 0) {
+      responses::put(key, response, counts.block);
+    }
+    return response;
+  }
+
+  size_t gqlCacheHits() {
+    return responses::hits;
+  }
+
+  size_t gqlCacheMisses() {
+    return responses::misses;
   }
 }  // namespace bcx
@@ -5,6 +5,8 @@
 
 namespace bcx {
   std::string gql(const std::string &body);
+  size_t gqlCacheHits();
+  size_t gqlCacheMisses();
 }  // namespace bcx
 
 #endif  // BCX_GQL_SERVICE_HPP
@@ -10,7 +10,7 @@ namespace graphql::bcx {
   }
 
   FieldResult<std::shared_ptr<object::Account>> Transaction::getCreatedBy(FieldParams&& params) const {
-    return std::make_shared<Account>(db::tx_creator[i]);
+    return allocate<Account>(params, db::tx_creator[i]);
   }
 
   FieldResult<StringType> Transaction::getTime(FieldParams&& params) const {
@@ -31,7 +31,8 @@ namespace graphql::bcx {
 
   FieldResult<StringType> Transaction::getCommandsJson(FieldParams&& params) const {
     auto cmd = db::tx_cmds[i];
-    return format::txCmdJson({db::block_bytes[txBlock(i)].data() + cmd.first, cmd.second});
+    auto bytes = db::block_bytes.get(txBlock(i));
+    return format::txCmdJson({bytes.view.data() + cmd.first, cmd.second});
   }
 
   FieldResult<std::shared_ptr<object::Transaction>> Query::getTransactionByHash(FieldParams&& params, StringType&& hashArg) const {
@@ -40,23 +41,55 @@ namespace graphql::bcx {
       return nullptr;
     }
     auto i = db::tx_hash.find(*hash);
-    return i ? std::make_shared<Transaction>(*i) : nullptr;
+    return i && *i < counts(params).tx ? allocate<Transaction>(params, *i) : nullptr;
   }
 
-  FieldResult<std::shared_ptr<object::TransactionList>> Query::getTransactionList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg, std::optional<StringType>&& creatorIdArg) const {
-    // TODO: creatorIdArg
+  Page transactionPage(const db::Counts &counts,
+                       std::optional<IntType> after_arg,
+                       IntType count,
+                       const std::optional<StringType> &time_after_arg,
+                       const std::optional<StringType> &time_before_arg,
+                       const std::optional<StringType> &creator_id_arg,
+                       bool reverse) {
     std::vector<size_t> iv;
-    auto time_after = timeAfterArg ? format::isoToTime(*timeAfterArg) : std::nullopt;
-    auto time_before = timeBeforeArg ? format::isoToTime(*timeBeforeArg) : std::nullopt;
-    auto after = afterArg ? *afterArg : -1;
-    auto i = after + 1;
+    auto time_after = time_after_arg ? format::isoToTime(*time_after_arg) : std::nullopt;
+    auto time_before = time_before_arg ? format::isoToTime(*time_before_arg) : std::nullopt;
+    auto txs_total = static_cast<int>(counts.tx);
+    auto after = after_arg ? *after_arg : reverse ? txs_total : -1;
+    // transactions in [begin, end) are candidates
+    auto begin = std::max(reverse ? 0 : after + 1, 0);
+    auto end = std::min(reverse ? after : txs_total, txs_total);
     if (time_after) {
-      i = std::max(i, static_cast<int>(std::lower_bound(db::tx_time.begin() + i, db::tx_time.end(), *time_after) - db::tx_time.begin()));
+      begin = std::max(begin, static_cast<int>(std::lower_bound(db::tx_time.begin(), db::tx_time.begin() + txs_total, *time_after) - db::tx_time.begin()));
     }
-    while (i >= 0 && i < db::txCount() && iv.size() < countArg && (!time_before || db::tx_time[i] < *time_before)) {
+    if (time_before) {
+      end = std::min(end, static_cast<int>(std::lower_bound(db::tx_time.begin(), db::tx_time.begin() + txs_total, *time_before) - db::tx_time.begin()));
+    }
+    auto take = [&](size_t i) {
+      if (iv.size() >= count) {
+        return false;
+      }
       iv.push_back(i);
-      ++i;
+      return true;
+    };
+    if (creator_id_arg) {
+      auto creator = db::account_id.find(*creator_id_arg);
+      if (creator && *creator < counts.account && begin < end) {
+        std::shared_lock lock{db::account_txs_mutex};
+        db::account_txs[*creator].scan(begin, end, reverse, take);
+      }
+    } else if (reverse) {
+      for (auto i = end; i-- > begin && take(i);) {
+      }
+    } else {
+      for (auto i = begin; i < end && take(i); ++i) {
+      }
     }
-    return TransactionList::make(std::move(iv), after);
+    return {std::move(iv), static_cast<size_t>(after)};
+  }
+
+  FieldResult<std::shared_ptr<object::TransactionList>> Query::getTransactionList(FieldParams&& params, std::optional<IntType>&& afterArg, IntType&& countArg, std::optional<StringType>&& timeAfterArg, std::optional<StringType>&& timeBeforeArg, std::optional<StringType>&& creatorIdArg, std::optional<BooleanType>&& reverseArg) const {
+    auto page = transactionPage(counts(params), afterArg, countArg, timeAfterArg, timeBeforeArg, creatorIdArg, reverseArg && *reverseArg);
+    return TransactionList::make(params, std::move(page.items), page.after);
   }
 }  // namespace graphql::bcx
@@ -1,35 +1,25 @@
 #include <belle.hh>
+#include <thread>
 
 #include "db/db.hpp"
 #include "format/format.hpp"
 #include "gql/service.hpp"
 #include "server/server.hpp"
+#include "sync/sync.hpp"
 
 namespace bcx {
   auto graphiqlHtml = format::readText("graphiql.html");
 
-  Server::Server() : app(std::make_shared<OB::Belle::Server>("0.0.0.0", 4000)) {
+  void addAdminRoutes(OB::Belle::Server &app) {
     using OB::Belle::Method;
     constexpr auto kContentType = boost::beast::http::field::content_type;
 
-    app->public_dir("frontend");
-
-    app->on_http("/graphql", Method::get, [](auto &ctx) {
-      ctx.res.set(kContentType, "text/html");
-      ctx.res.body() = graphiqlHtml;
-    });
-
-    app->on_http("/graphql", Method::post, [](auto &ctx) {
-      ctx.res.set(kContentType, "application/json");
-      ctx.res.body() = gql(ctx.req.body());
-    });
-
-    app->on_http("/health", Method::get, [](auto &ctx) {
+    app.on_http("/health", Method::get, [](auto &ctx) {
       ctx.res.set(kContentType, "application/json");
       ctx.res.body() = "{\"status\":\"UP\"}";
     });
 
-    app->on_http("/metrics", Method::get, [](auto &ctx) {
+    app.on_http("/metrics", Method::get, [](auto &ctx) {
       std::stringstream s;
       auto counter = [&s](const std::string &type, size_t count) {
         auto key = "explorer_" + type + "_total";
@@ -38,15 +28,28 @@ namespace bcx {
         s << key << " " << count << "\n";
         s << "\n";
       };
+      auto gauge = [&s](const std::string &type, size_t value) {
+        auto key = "explorer_" + type;
+        s << "#HELP " << key << " " << type << "\n";
+        s << "#TYPE " << key << " gauge\n";
+        s << key << " " << value << "\n";
+        s << "\n";
+      };
       counter("blocks", db::blockCount());
+      counter("durable_blocks", db::durableBlockCount());
       counter("transactions", db::txCount());
       counter("accounts", db::accountCount());
       counter("peers", db::peerCount());
+      counter("graphql_cache_hits", gqlCacheHits());
+      counter("graphql_cache_misses", gqlCacheMisses());
+      gauge("sync_reorder_blocks", syncReorderBlocks());
+      gauge("sync_reorder_capacity", syncReorderCapacity());
+      counter("sync_head_wait_ms", syncHeadWaitMs());
       ctx.res.set(kContentType, "text/plain");
       ctx.res.body() = s.str();
     });
 
-    app->on_http("/logLevel", Method::post, [](auto &ctx) {
+    app.on_http("/logLevel", Method::post, [](auto &ctx) {
       auto query = ctx.req.params();
       auto param = query.find("level");
       if (param == query.end() || !setLogLevel(param->second)) {
@@ -56,12 +59,49 @@ namespace bcx {
     });
   }
 
+  Server::Server() : app(std::make_shared<OB::Belle::Server>("0.0.0.0", 4000)) {
+    using OB::Belle::Method;
+    constexpr auto kContentType = boost::beast::http::field::content_type;
+
+    app->threads(config.http_threads);
+    app->public_dir("frontend");
+
+    app->on_http("/graphql", Method::get, [](auto &ctx) {
+      ctx.res.set(kContentType, "text/html");
+      ctx.res.body() = graphiqlHtml;
+    });
+
+    app->on_http("/graphql", Method::post, [](auto &ctx) {
+      ctx.res.set(kContentType, "application/json");
+      ctx.res.body() = gql(ctx.req.body());
+    });
+
+    addAdminRoutes(*app);
+
+    if (config.admin_port != 0) {
+      admin = std::make_shared<OB::Belle::Server>("0.0.0.0", config.admin_port);
+      admin->threads(1);
+      addAdminRoutes(*admin);
+    }
+  }
+
   boost::asio::io_context &Server::io() {
     return app->io();
   }
 
   void Server::run() {
-    logger::info("Server is running on localhost:{}", app->port());
+    std::thread admin_thread;
+    if (admin) {
+      admin_thread = std::thread{[this]() {
+        logger::info("Admin server is running on localhost:{}", admin->port());
+        admin->listen();
+      }};
+    }
+    logger::info("Server is running on localhost:{} with {} threads", app->port(), config.http_threads);
     app->listen();
+    if (admin_thread.joinable()) {
+      admin->io().stop();
+      admin_thread.join();
+    }
   }
 }  // namespace bcx
@@ -12,12 +12,14 @@ namespace OB::Belle {
 }  // namespace OB::Belle
 
 namespace bcx {
+  // graphql on pool of threads, /health and /metrics also on separate admin port and thread
   struct Server {
     Server();
     boost::asio::io_context &io();
     void run();
 
     std::shared_ptr<OB::Belle::Server> app;
+    std::shared_ptr<OB::Belle::Server> admin;
   };
 }  // namespace bcx
 
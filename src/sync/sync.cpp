@@ -1,8 +1,16 @@
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <ed25519/ed25519.h>
+#include <grpcpp/alarm.h>
 #include <grpcpp/grpcpp.h>
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <thread>
 
 #include "db/db.hpp"
@@ -11,8 +19,9 @@
 #include "sync/sync.hpp"
 
 namespace bcx {
-  constexpr auto kGetBlockThreads = 10u;
-  constexpr auto kGetBlockQueue = 30u;
+  constexpr auto kGetBlockTimeout = std::chrono::seconds{60};
+  constexpr auto kGetBlockRetries = 10u;
+  constexpr auto kGetBlockRetryDelay = std::chrono::milliseconds{100};
 
   struct IrohaApi {
     IrohaApi(const Config::Iroha &config)
@@ -50,16 +59,41 @@ namespace bcx {
     }
 
     void getBlock(iroha::protocol::QueryResponse &res, size_t height) {
+      find(res, getBlockQuery(height));
+    }
+
+    // async GetBlock, completes on queue with call as tag.
+    // retry is new call without reader, waiting for delay alarm.
+    struct GetBlockCall {
+      size_t height;
+      size_t seq;
+      unsigned attempt;
+      std::optional<grpc::Alarm> delay;
+      std::chrono::steady_clock::time_point start;
+      grpc::ClientContext ctx;
+      iroha::protocol::QueryResponse res;
+      grpc::Status status;
+      std::unique_ptr<grpc::ClientAsyncResponseReader<iroha::protocol::QueryResponse>> reader;
+    };
+
+    void getBlock(GetBlockCall &call, grpc::CompletionQueue &cq) {
+      call.start = std::chrono::steady_clock::now();
+      call.ctx.set_deadline(std::chrono::system_clock::now() + kGetBlockTimeout);
+      call.reader = service.AsyncFind(&call.ctx, getBlockQuery(call.height), &cq);
+      call.reader->Finish(&call.res, &call.status, &call);
+    }
+
+    iroha::protocol::Query getBlockQuery(size_t height) {
       iroha::protocol::Query query;
       auto payload = query.mutable_payload();
       payload->mutable_get_block()->set_height(height);
       setMeta(*payload->mutable_meta());
       sign(*query.mutable_signature(), *payload);
-      find(res, query);
+      return query;
     }
 
     void find(iroha::protocol::QueryResponse &res,
-              iroha::protocol::Query &query) {
+              const iroha::protocol::Query &query) {
       grpc::ClientContext ctx;
       auto status = service.Find(&ctx, query, &res);
       if (!status.ok()) {
@@ -105,81 +139,261 @@ namespace bcx {
     public_key_t ed_public_key;
   };
 
-  struct BlockHeightLess {
-    auto operator()(const iroha::protocol::Block &lhs, const iroha::protocol::Block &rhs) const {
-      return format::blockHeight(lhs) > format::blockHeight(rhs);
+  // aimd limit of calls in flight.
+  // grows by one per response until first congestion, then by one per window of responses.
+  // halves on errors and when smoothed latency exceeds twice the baseline,
+  // at most once per window so responses to calls sent before cut don't cut again.
+  // baseline follows lowest latency, and slowly rises with it as blocks get bigger.
+  class Window {
+   public:
+    using Duration = std::chrono::duration<double>;
+
+    explicit Window(size_t max) : max_{std::max<size_t>(max, 1)} {}
+
+    size_t size() const {
+      return size_;
+    }
+
+    // sequence number of new call
+    size_t start() {
+      return started_++;
+    }
+
+    void success(size_t seq, Duration latency) {
+      if (!baseline_ || latency < *baseline_) {
+        baseline_ = latency;
+        smooth_ = latency;
+      }
+      *baseline_ += (latency - *baseline_) / 64;
+      smooth_ += (latency - smooth_) / 8;
+      if (smooth_ > *baseline_ * 2) {
+        cut(seq);
+        return;
+      }
+      growth_ += congested_ ? 1.0 / size_ : 1.0;
+      if (growth_ >= 1) {
+        growth_ = 0;
+        size_ = std::min(size_ + 1, max_);
+      }
+    }
+
+    void failure(size_t seq) {
+      cut(seq);
+    }
+
+   private:
+    void cut(size_t seq) {
+      if (seq < cut_seq_) {
+        return;
+      }
+      congested_ = true;
+      growth_ = 0;
+      size_ = std::max<size_t>(size_ / 2, 1);
+      cut_seq_ = started_;
+    }
+
+    size_t max_;
+    size_t size_ = 1;
+    size_t started_ = 0;
+    size_t cut_seq_ = 0;
+    bool congested_ = false;
+    double growth_ = 0;
+    std::optional<Duration> baseline_;
+    Duration smooth_{};
+  };
+
+  // fetched blocks waiting for lower heights, in ring slot `height % capacity`.
+  // fetchers wait until height fits below `next + capacity`, so buffer is bounded.
+  // head wait is time later blocks spend waiting for missing next block.
+  namespace reorder {
+    static std::atomic_size_t blocks, capacity, head_wait_ns;
+  }  // namespace reorder
+
+  class Reorder {
+   public:
+    Reorder(size_t capacity, size_t next) : ring_(std::max<size_t>(capacity, 1)), next_{next} {
+      reorder::capacity = ring_.size();
+    }
+
+    bool fits(size_t height) {
+      std::lock_guard lock{mutex_};
+      return height < next_ + ring_.size();
+    }
+
+    void reserve(size_t height) {
+      std::unique_lock lock{mutex_};
+      fits_cv_.wait(lock, [&]() { return height < next_ + ring_.size(); });
+    }
+
+    // true if writer must be posted to take blocks, height must be reserved
+    bool put(db::Prepared &&prepared) {
+      auto height = format::blockHeight(prepared.block);
+      std::lock_guard lock{mutex_};
+      auto &slot = ring_[height % ring_.size()];
+      if (height < next_ || slot) {
+        return false;
+      }
+      slot = std::move(prepared);
+      reorder::blocks = ++size_;
+      if (height != next_) {
+        if (!head_missing_since_) {
+          head_missing_since_ = std::chrono::steady_clock::now();
+        }
+        return false;
+      }
+      if (head_missing_since_) {
+        reorder::head_wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - *head_missing_since_).count();
+        head_missing_since_.reset();
+      }
+      return !std::exchange(posted_, true);
+    }
+
+    // consecutive blocks from next
+    std::vector<db::Prepared> take() {
+      std::vector<db::Prepared> batch;
+      {
+        std::lock_guard lock{mutex_};
+        posted_ = false;
+        for (auto *slot = &ring_[next_ % ring_.size()]; *slot; slot = &ring_[next_ % ring_.size()]) {
+          batch.emplace_back(std::move(**slot));
+          slot->reset();
+          ++next_;
+          --size_;
+        }
+        if (size_ != 0 && !head_missing_since_) {
+          head_missing_since_ = std::chrono::steady_clock::now();
+        }
+        reorder::blocks = size_;
+      }
+      fits_cv_.notify_all();
+      return batch;
     }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable fits_cv_;
+    std::vector<std::optional<db::Prepared>> ring_;
+    size_t next_;
+    size_t size_ = 0;
+    bool posted_ = false;
+    std::optional<std::chrono::steady_clock::time_point> head_missing_since_;
   };
 
-  void runSync(boost::asio::io_context &io) {
+  void runSync() {
     IrohaApi api{*config.iroha};
     auto last_height = db::blockCount();
-    iroha::protocol::Block last_block;
-    if (last_height != 0) {
-      if (!api.getBlock(last_block, last_height) || format::blockHash(last_block) != db::block_hash[last_height - 1]) {
-        db::drop();
-        fatal("Last cached block differs, invalidating block cache");
+    auto same = [&](size_t height) {
+      iroha::protocol::Block block;
+      return api.getBlock(block, height) && format::blockHash(block) == db::block_hash[height - 1];
+    };
+    if (last_height != 0 && !same(last_height)) {
+      // chains share prefix, binary search for last common block
+      size_t common = 0, differs = last_height;
+      while (differs - common > 1) {
+        auto height = common + (differs - common) / 2;
+        (same(height) ? common : differs) = height;
       }
+      logger::warn("Cached block {} differs, rolling back to {}", differs, common);
+      db::rollback(common);
+      last_height = common;
     }
     auto next_height = last_height + 1;
     logger::info("Sync start");
 
-    std::priority_queue<iroha::protocol::Block, std::vector<iroha::protocol::Block>, BlockHeightLess> q;
+    // blocks are prepared on `LOAD_THREADS` workers and applied on single writer thread,
+    // readers don't wait for it.
+    // writer is posted once for all blocks prepared meanwhile.
+    boost::asio::io_context io;
+    boost::asio::executor_work_guard guard{io.get_executor()};
+    std::thread writer{[&]() { io.run(); }};
+    boost::asio::thread_pool workers{config.load_threads};
+    Reorder reorder{config.iroha->reorder_blocks, next_height};
+    auto applyReady = [&]() {
+      auto batch = reorder.take();
+      for (auto &prepared : batch) {
+        logger::info("Sync block {}", format::blockHeight(prepared.block));
+      }
+      db::addBlocks(batch);
+    };
+    // waits for room in reorder buffer
     auto postBlock = [&](iroha::protocol::Block &&block) {
-      io.post([&, block=std::move(block)]() {
-        q.push(block);
-        while (!q.empty()) {
-          auto height = format::blockHeight(q.top());
-          if (height > next_height) {
-            break;
-          }
-          if (height == next_height) {
-            logger::info("Sync block {}", format::blockHeight(q.top()));
-            db::addBlock(q.top());
-            ++next_height;
-          }
-          q.pop();
+      reorder.reserve(format::blockHeight(block));
+      auto prepared = std::make_unique<db::Prepared>();
+      prepared->block = std::move(block);
+      boost::asio::post(workers, [&, prepared = std::move(prepared)]() {
+        db::prepare(*prepared);
+        if (reorder.put(std::move(*prepared))) {
+          io.post(applyReady);
         }
       });
     };
 
-    boost::asio::io_context wio;
-    boost::asio::executor_work_guard wguard{wio.get_executor()};
-    std::vector<std::thread> wthreads;
-    for (auto i = 0u; i < kGetBlockThreads; ++i) {
-      wthreads.emplace_back([&]() { wio.run(); });
-    }
+    // catch up with async GetBlock calls on this thread, until node returns error for some height
+    auto stream = api.fetchCommits();
+    grpc::CompletionQueue cq;
+    Window window{config.iroha->max_in_flight};
     auto qheight = next_height;
     auto qheight_max = std::numeric_limits<size_t>::max();
-    auto stream = api.fetchCommits();
-    boost::asio::io_context qio;
-    boost::asio::executor_work_guard qguard{qio.get_executor()};
-    auto qjob = [&](const auto &qjob2) -> void {
-      if (qheight >= qheight_max) {
-        qio.stop();
-      } else {
-        wio.post([&, qheight]() {
-          if (qheight < qheight_max) {
-            iroha::protocol::Block block;
-            if (api.getBlock(block, qheight)) {
-              postBlock(std::move(block));
-            } else {
-              qheight_max = std::min(qheight_max, qheight);
-            }
-            qio.post([&]() { qjob2(qjob2); });
-          }
-        });
-        ++qheight;
-      }
+    // includes retries waiting for delay
+    size_t in_flight = 0;
+    auto send = [&](std::unique_ptr<IrohaApi::GetBlockCall> call) {
+      call->seq = window.start();
+      api.getBlock(*call, cq);
+      call.release();
     };
-    for (auto i = 0; i < kGetBlockQueue; ++i) {
-      qjob(qjob);
-    }
-    qio.run();
-    wguard.reset();
-    for (auto &thread : wthreads) {
-      thread.join();
+    while (true) {
+      while (in_flight < window.size() && qheight < qheight_max && reorder.fits(qheight)) {
+        auto call = std::make_unique<IrohaApi::GetBlockCall>();
+        call->height = qheight++;
+        call->attempt = 0;
+        send(std::move(call));
+        ++in_flight;
+      }
+      if (in_flight == 0) {
+        if (qheight >= qheight_max) {
+          break;
+        }
+        reorder.reserve(qheight);
+        continue;
+      }
+      void *tag;
+      bool ok;
+      if (!cq.Next(&tag, &ok)) {
+        fatal("GRPC completion queue shutdown");
+      }
+      std::unique_ptr<IrohaApi::GetBlockCall> call{static_cast<IrohaApi::GetBlockCall *>(tag)};
+      if (call->height >= qheight_max) {
+        --in_flight;
+        continue;
+      }
+      if (!call->reader) {
+        send(std::move(call));
+        continue;
+      }
+      if (!ok || !call->status.ok()) {
+        window.failure(call->seq);
+        if (call->attempt == kGetBlockRetries) {
+          fatal("GRPC error {}", call->status.error_message());
+        }
+        logger::warn("GetBlock {} error {}, retrying", call->height, call->status.error_message());
+        auto retry = std::make_unique<IrohaApi::GetBlockCall>();
+        retry->height = call->height;
+        retry->attempt = call->attempt + 1;
+        retry->delay.emplace();
+        retry->delay->Set(&cq, std::chrono::system_clock::now() + kGetBlockRetryDelay * retry->attempt, retry.get());
+        retry.release();
+        continue;
+      }
+      --in_flight;
+      window.success(call->seq, std::chrono::steady_clock::now() - call->start);
+      if (call->res.has_error_response()) {
+        qheight_max = std::min(qheight_max, call->height);
+        continue;
+      }
+      postBlock(std::move(*call->res.mutable_block_response()->mutable_block()));
     }
+    cq.Shutdown();
+    logger::info("Sync caught up with {} calls in flight", window.size());
     io.post([]() { logger::info("Sync wait for new blocks"); });
     iroha::protocol::BlockQueryResponse res;
     while (stream.first->Read(&res)) {
@@ -192,6 +406,21 @@ namespace bcx {
     if (!status.ok()) {
       fatal("GRPC error {}", status.error_message());
     }
+    workers.join();
+    guard.reset();
+    writer.join();
     logger::info("Sync stop");
   }
+
+  size_t syncReorderBlocks() {
+    return reorder::blocks;
+  }
+
+  size_t syncReorderCapacity() {
+    return reorder::capacity;
+  }
+
+  size_t syncHeadWaitMs() {
+    return reorder::head_wait_ns / 1000000;
+  }
 }  // namespace bcx
@@ -1,12 +1,15 @@
 #ifndef BCX_SYNC_SYNC_HPP
 #define BCX_SYNC_SYNC_HPP
 
-namespace boost::asio {
-  class io_context;
-}  // namespace boost::asio
+#include <cstddef>
 
 namespace bcx {
-  void runSync(boost::asio::io_context &io);
+  void runSync();
+  // blocks waiting in reorder buffer for lower heights, and its capacity
+  size_t syncReorderBlocks();
+  size_t syncReorderCapacity();
+  // total time later blocks waited for missing next block
+  size_t syncHeadWaitMs();
 }  // namespace bcx
 
 #endif  // BCX_SYNC_SYNC_HPP
@@ -20,8 +20,11 @@ namespace bcx {
   constexpr size_t kGrantPermsBits = 5;
   using GrantPerms = std::bitset<kGrantPermsBits>;
 
+  // entity ids and offsets inside block, max value is reserved for null
+  using Id = uint32_t;
+
   struct Grant {
-    size_t by, to, perm;
+    Id by, to, perm;
   };
 
   inline auto b2c(Byte *ptr) {